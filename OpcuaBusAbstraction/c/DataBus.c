@@ -8,25 +8,44 @@ The above copyright notice and this permission notice shall be included in all c
 THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#define _DEFAULT_SOURCE 1
+
 #include "DataBus.h"
 
-static char gDirection[4];
+// Publisher or subscriber context, only one of server and client is set
+struct DataBusContext {
+    struct ServerContext *server;
+    struct ClientContext *client;
+};
+
+/* Returns the server of the context, NULL for subscriber contexts */
+static struct ServerContext*
+contextServer(struct DataBusContext *context) {
+    return (context != NULL) ? context->server : NULL;
+}
 
 char*
-ContextCreate(struct ContextConfig contextConfig) {
+ContextCreate(struct ContextConfig contextConfig,
+              struct DataBusContext **context) {
     char *hostname;
     char *errorMsg = "0";
     unsigned int port;
     bool devmode = false;
-    DBA_STRCPY(gDirection, contextConfig.direction);
-    char *hostNamePort[3];
+    struct DataBusContext *ctx = (struct DataBusContext*) calloc(1, sizeof(struct DataBusContext));
+    *context = NULL;
+    if (ctx == NULL) {
+        static char str[] = "DataBus context allocation has failed";
+        return str;
+    }
+    char *hostNamePort[3] = {NULL, NULL, NULL};
     char *delimeter = "://";
     char *endpointStr = contextConfig.endpoint;
-    char *endpointArr = strtok(endpointStr, delimeter);
+    char *savePtr = NULL;
+    char *endpointArr = strtok_r(endpointStr, delimeter, &savePtr);
     if (endpointArr != NULL) {
-        for (int i = 0; endpointArr != NULL; i++) {
+        for (int i = 0; endpointArr != NULL && i < 3; i++) {
             hostNamePort[i] = endpointArr;
-            endpointArr = strtok(NULL, delimeter);
+            endpointArr = strtok_r(NULL, delimeter, &savePtr);
         }
         if (hostNamePort[1] != NULL && hostNamePort[2] != NULL) {
             hostname = hostNamePort[1];
@@ -39,41 +58,104 @@ ContextCreate(struct ContextConfig contextConfig) {
             if (hostname != NULL) {
                 if (devmode) {
                     if (!strcmp(contextConfig.direction, "PUB")) {
-                        errorMsg = serverContextCreate(hostname, port);
+                        errorMsg = serverContextCreate(&ctx->server, hostname, port,
+                                                       contextConfig.notifyOnWrite,
+                                                       contextConfig.serverWorkers);
                     } else if (!strcmp(contextConfig.direction, "SUB")) {
-                        errorMsg = clientContextCreate(hostname, port);
+                        errorMsg = clientContextCreate(&ctx->client, hostname, port,
+                                                       contextConfig.dispatchWorkers);
                     }
                 } else {
                     if (!strcmp(contextConfig.direction, "PUB")) {
-                        errorMsg = serverContextCreateSecured(hostname, port, contextConfig.certFile,
+                        errorMsg = serverContextCreateSecured(&ctx->server, hostname, port, contextConfig.certFile,
                                                               contextConfig.privateFile, contextConfig.trustFile,
-                                                              contextConfig.trustedListSize);
+                                                              contextConfig.trustedListSize,
+                                                              contextConfig.notifyOnWrite,
+                                                              contextConfig.serverWorkers);
                     } else if (!strcmp(contextConfig.direction, "SUB")) {
-                        errorMsg = clientContextCreateSecured(hostname, port, contextConfig.certFile,
+                        errorMsg = clientContextCreateSecured(&ctx->client, hostname, port, contextConfig.certFile,
                                                               contextConfig.privateFile, contextConfig.trustFile,
-                                                              contextConfig.trustedListSize);
+                                                              contextConfig.trustedListSize,
+                                                              contextConfig.dispatchWorkers);
                     }
                 }
             }
         }
     }
+    if (strcmp(errorMsg, "0")) {
+        free(ctx);
+        return errorMsg;
+    }
+    *context = ctx;
     return errorMsg;
 }
 
 char*
-Publish(struct TopicConfig topicConfig, const char *data) {
-    return serverPublish(topicConfig, data);
+Publish(struct DataBusContext *context, struct TopicConfig topicConfig, const char *data) {
+    return serverPublish(contextServer(context), topicConfig, data);
+}
+
+char*
+PublishBytes(struct DataBusContext *context, struct TopicConfig topicConfig, const uint8_t *buf, size_t len) {
+    return serverPublishBytes(contextServer(context), topicConfig, buf, len);
+}
+
+char*
+PublishValues(struct DataBusContext *context, struct TopicConfig topicConfig, const void *values, size_t count) {
+    return serverPublishValues(contextServer(context), topicConfig, values, count);
+}
+
+char*
+PublishBatch(struct DataBusContext *context, struct TopicConfig *topicConfigs, const char **data,
+             const size_t *lens, size_t count) {
+    return serverPublishBatch(contextServer(context), topicConfigs, data, lens, count);
+}
+
+char*
+PublishPayload(struct DataBusContext *context, struct TopicConfig topicConfig, struct Payload *payload) {
+    return serverPublishPayload(contextServer(context), topicConfig, payload);
+}
+
+char*
+GetServerMetrics(struct DataBusContext *context, struct ServerMetrics *metrics) {
+    return serverMetrics(contextServer(context), metrics);
+}
+
+char*
+GetTopicMetrics(struct DataBusContext *context, struct TopicMetrics *metrics, size_t size, size_t *count) {
+    return serverTopicMetrics(contextServer(context), metrics, size, count);
+}
+
+char*
+PublishMetrics(struct DataBusContext *context) {
+    return serverPublishMetrics(contextServer(context));
+}
+
+char*
+Subscribe(struct DataBusContext *context, struct TopicConfig topicConfigs[], unsigned int topicConfigCount,
+          const char *trig, c_callback cb, void* pyxFunc) {
+    return clientSubscribe((context != NULL) ? context->client : NULL, topicConfigs, topicConfigCount,
+                           cb, pyxFunc);
+}
+
+char*
+SubscribeData(struct DataBusContext *context, struct TopicConfig topicConfigs[], unsigned int topicConfigCount,
+              const char *trig, c_data_callback cb, void *userFunc) {
+    return clientSubscribeData((context != NULL) ? context->client : NULL, topicConfigs, topicConfigCount,
+                               cb, userFunc);
 }
 
 char*
-Subscribe(struct TopicConfig topicConfigs[], unsigned int topicConfigCount, const char *trig, c_callback cb, void* pyxFunc) {
-    return clientSubscribe(topicConfigs, topicConfigCount, cb, pyxFunc);
+GetDispatchCounters(struct DataBusContext *context, struct TopicConfig topicConfig,
+                    struct DispatchCounters *counters) {
+    return clientDispatchCounters((context != NULL) ? context->client : NULL, topicConfig, counters);
 }
 
-void ContextDestroy() {
-    if (!strcmp(gDirection, "PUB")) {
-        serverContextDestroy();
-    } else if (!strcmp(gDirection, "SUB")) {
-        clientContextDestroy();
+void ContextDestroy(struct DataBusContext *context) {
+    if (context == NULL) {
+        return;
     }
+    clientContextDestroy(context->client);
+    serverContextDestroy(context->server);
+    free(context);
 }
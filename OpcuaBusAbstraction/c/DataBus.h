@@ -12,6 +12,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 
 //*************C bindings**********************
+/** DataBusContext is the handle of an opcua publisher (server) or subscriber (client) context.
+ * A process can create several of them, e.g. servers on different ports or a publisher and a
+ * subscriber talking to each other */
+struct DataBusContext;
+
 /**ContextCreate function creates the opcua server/client (pub/sub) context based on `ContextConfig`.direction field
  *
  * @param contextConfig(struct)      ContextConfig structure for opcua publisher/subscriber
@@ -21,21 +26,112 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
  *                                   subscriber (client)- If all certs/keys are set to empty string in ContextConfig structure, 
  *                                   the opcua client tries to establishes insecure connection 
  *                                   If not, it tries to establish secure connection with the opcua server
+ * @param context(struct DataBusContext) set to the handle of the created context, NULL on failure
  * @return string "0" for success and other string for failure of the function
 */
 char*
-ContextCreate(struct ContextConfig contextConfig);
+ContextCreate(struct ContextConfig contextConfig,
+              struct DataBusContext **context);
 
 /**Publish function for publishing the data by opcua server process
  *
+ * @param  context(struct)           handle of a publisher context
  * @param  topicConfig(struct)       opcua `struct TopicConfig` structure
  * @param  data(string)              data to be written to opcua variable
  * @return string "0" for success and other string for failure of the function */
 char*
-Publish(struct TopicConfig topicConfig,
+Publish(struct DataBusContext *context,
+        struct TopicConfig topicConfig,
         const char *data);
 
+/**PublishBytes function for publishing binary data by opcua server process, the data is
+ * written to the opcua variable as a ByteString
+ *
+ * @param  context(struct)           handle of a publisher context
+ * @param  topicConfig(struct)       opcua `struct TopicConfig` structure
+ * @param  buf(array)                data to be written to opcua variable
+ * @param  len(size_t)               length of buf in bytes
+ * @return string "0" for success and other string for failure of the function */
+char*
+PublishBytes(struct DataBusContext *context,
+             struct TopicConfig topicConfig,
+             const uint8_t *buf,
+             size_t len);
+
+/**PublishValues function for publishing numbers, booleans and timestamps by opcua server process,
+ * with the opcua data type selected by topicConfig.dType (see serverPublishValues)
+ *
+ * @param  context(struct)           handle of a publisher context
+ * @param  topicConfig(struct)       opcua `struct TopicConfig` structure
+ * @param  values(array)             C array of the values to be written to opcua variable
+ * @param  count(size_t)             number of values, 1 for scalar topics
+ * @return string "0" for success and other string for failure of the function */
+char*
+PublishValues(struct DataBusContext *context,
+              struct TopicConfig topicConfig,
+              const void *values,
+              size_t count);
+
+/**PublishBatch function for publishing the data of several topics at once by opcua server process
+ *
+ * @param  context(struct)           handle of a publisher context
+ * @param  topicConfigs(array)       array of `struct TopicConfig` structure instances
+ * @param  data(array)               data to be written to each opcua variable
+ * @param  lens(array)               length of each data in bytes
+ * @param  count(size_t)             length of topicConfigs, data and lens arrays
+ * @return string "0" for success and other string for failure of the function */
+char*
+PublishBatch(struct DataBusContext *context,
+             struct TopicConfig *topicConfigs,
+             const char **data,
+             const size_t *lens,
+             size_t count);
+
+/**PublishPayload function for publishing a payload created with payloadNew by opcua server process
+ * without copying it. The caller's reference to payload is handed over even on failure
+ *
+ * @param  context(struct)           handle of a publisher context
+ * @param  topicConfig(struct)       opcua `struct TopicConfig` structure
+ * @param  payload(struct Payload)   payload to be written to opcua variable
+ * @return string "0" for success and other string for failure of the function */
+char*
+PublishPayload(struct DataBusContext *context,
+               struct TopicConfig topicConfig,
+               struct Payload *payload);
+
+/**GetServerMetrics function gets the server wide metrics of the opcua server process (see serverMetrics)
+ *
+ * @param  context(struct)                handle of a publisher context
+ * @param  metrics(struct ServerMetrics)  set to the metrics of the server
+ * @return string "0" for success and other string for failure of the function */
+char*
+GetServerMetrics(struct DataBusContext *context,
+                 struct ServerMetrics *metrics);
+
+/**GetTopicMetrics function gets the publish metrics of the topics of the opcua server process
+ * (see serverTopicMetrics)
+ *
+ * @param  context(struct)           handle of a publisher context
+ * @param  metrics(array)            set to the metrics of the first size topics
+ * @param  size(size_t)              length of metrics array
+ * @param  count(size_t)             set to the number of topics, which may exceed size
+ * @return string "0" for success and other string for failure of the function */
+char*
+GetTopicMetrics(struct DataBusContext *context,
+                struct TopicMetrics *metrics,
+                size_t size,
+                size_t *count);
+
+/**PublishMetrics function mirrors the metrics of the opcua server process to the variables of its
+ * Diagnostics folder (see serverPublishMetrics)
+ *
+ * @param  context(struct)           handle of a publisher context
+ * @return string "0" for success and other string for failure of the function */
+char*
+PublishMetrics(struct DataBusContext *context);
+
 /**Subscribe function makes the subscription to the list of opcua variables (topics) in topicConfig array
+ * @param  context(struct)                    handle of a subscriber context
  * @param  topicConfigs(array)                array of `struct TopicConfig` structure instances
  * @param  topicConfigCount(unsigned int)     length of topicConfigs array
  * @param  trig(string)                       opcua trigger ex: START | STOP
@@ -44,11 +140,40 @@ Publish(struct TopicConfig topicConfig,
  *                                            For c and go callbacks, just pass NULL and nil respectively
  * @return string "0" for success and other string for failure of the function */
 char*
-Subscribe(struct TopicConfig topicConfigs[],
+Subscribe(struct DataBusContext *context,
+          struct TopicConfig topicConfigs[],
           unsigned int topicConfigCount,
           const char *trig,
           c_callback cb,
           void* pyxFunc);
 
-/**ContextDestroy function destroys the opcua server/client context*/
-void ContextDestroy();
+/**SubscribeData function makes the subscription to the list of opcua variables (topics) in topicConfig array,
+ * handing each notification to cb as a `struct SubscribedData` view (see clientSubscribeData)
+ * @param  context(struct)                    handle of a subscriber context
+ * @param  topicConfigs(array)                array of `struct TopicConfig` structure instances
+ * @param  topicConfigCount(unsigned int)     length of topicConfigs array
+ * @param  trig(string)                       opcua trigger ex: START | STOP
+ * @param  cb(c_data_callback)                callback that sends out the subscribed data back to the caller
+ * @param  userFunc                           passed back to cb as is, may be NULL
+ * @return string "0" for success and other string for failure of the function */
+char*
+SubscribeData(struct DataBusContext *context,
+              struct TopicConfig topicConfigs[],
+              unsigned int topicConfigCount,
+              const char *trig,
+              c_data_callback cb,
+              void *userFunc);
+
+/**GetDispatchCounters function gets the counters of the dispatch queue of a subscribed topic of a
+ * subscriber context created with `ContextConfig`.dispatchWorkers
+ * @param  context(struct)                    handle of a subscriber context
+ * @param  topicConfig(struct)                opcua `struct TopicConfig` structure of the topic
+ * @param  counters(struct DispatchCounters)  set to the counters of the topic
+ * @return string "0" for success and other string for failure of the function */
+char*
+GetDispatchCounters(struct DataBusContext *context,
+                    struct TopicConfig topicConfig,
+                    struct DispatchCounters *counters);
+
+/**ContextDestroy function destroys the opcua server/client context and frees its handle*/
+void ContextDestroy(struct DataBusContext *context);
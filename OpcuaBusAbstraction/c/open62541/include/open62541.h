@@ -69,7 +69,10 @@
 
 /* Multithreading */
 /* #undef UA_ENABLE_IMMUTABLE_NODES */
-#define UA_MULTITHREADING 0
+/* EII patch 0002: can be set by the build */
+#ifndef UA_MULTITHREADING
+# define UA_MULTITHREADING 0
+#endif
 
 /* Advanced Options */
 #define UA_ENABLE_STATUSCODE_DESCRIPTIONS
@@ -30715,6 +30718,17 @@ UA_ServerNetworkLayer UA_EXPORT
 UA_ServerNetworkLayerTCP(UA_ConnectionConfig config, UA_UInt16 port,
                          UA_UInt16 maxConnections);
 
+/* EII patch 0002: sets SO_REUSEPORT on the server sockets of a TCP network
+ * layer, so that several servers can listen on the same port. Has to be set
+ * before the server is started.
+ *
+ * @param nl A network layer created with UA_ServerNetworkLayerTCP
+ * @param reusePort Whether the port can be shared
+ * @return Returns UA_STATUSCODE_BADINTERNALERROR for another network layer */
+UA_StatusCode UA_EXPORT
+UA_ServerNetworkLayerTCP_setReusePort(UA_ServerNetworkLayer *nl,
+                                      UA_Boolean reusePort);
+
 /* Open a non-blocking client TCP socket. The connection might not be fully
  * opened yet. Drop into the _poll function withe a timeout to complete the
  * connection. */
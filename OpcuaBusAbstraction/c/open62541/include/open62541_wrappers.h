@@ -30,6 +30,9 @@ strncpy_s (char *dest, unsigned int dmax, const char *src, unsigned int slen);
 #define TOPIC_SIZE 100
 // Setting this value to 61KB since influxdb supports a max size of 64KB
 #define PUBLISH_DATA_SIZE 61*1024
+// namespace of the variables serverPublishMetrics mirrors the metrics to, organized in its Diagnostics folder.
+// It is reserved, the publish functions reject the topics of this namespace
+#define DIAGNOSTICS_NAMESPACE "Diagnostics"
 #define DBA_STRCPY(dest, src) \
     { \
         unsigned int srcLength = (unsigned int)strlen(src) + 1; \
@@ -66,81 +69,300 @@ struct ContextConfig {
     char *privateFile;      ///< opcua private key file
     char **trustFile;       ///< opcua trust files list
     size_t trustedListSize; ///< opcua trust files list size
+    bool notifyOnWrite;     ///< PUB only: topics are value-backed variables that monitored items
+                            ///< sample only after a publish, instead of data sources read on every sample
+    size_t serverWorkers;   ///< PUB only: number of servers sharing the port, each serving its own
+                            ///< connections on its own thread, 0 or 1 for a single server
+    size_t dispatchWorkers; ///< SUB only: number of threads calling the callbacks, each serving its
+                            ///< share of the topics in order, 0 to call them on the client thread
 };
 
 // opcua topic config
 struct TopicConfig {
     char *ns;           ///< opcua namespace name
     char *name;         ///< opcua topic name
-    char *dType;        ///< type of topic, ex: string|int
+    char *dType;        ///< type of topic: string|bytes|boolean|int32|int|int64|float|double|datetime,
+                        ///< value types suffixed with [] are arrays, ex: double[]
 };
 
 //*************open62541 server wrappers**********************/
+/** ServerContext is the handle of an opcua server, each running its own server thread. Several
+ * servers can run in a process on different ports. A server with workers is a pool of servers
+ * listening on the same port (SO_REUSEPORT), between which the kernel balances the client
+ * connections, so that the sessions are served in parallel. Each of them gets every publish.
+ * The workers don't share their sessions and subscriptions: a client that reconnects can land on
+ * another worker, which rejects its ActivateSession and its subscription transfer, so the client
+ * has to create a new session and subscribe again */
+struct ServerContext;
+
 /**serverContextCreateSecured function builds the server context and starts the opcua server in secure mode
+ * @param  serverContext(struct ServerContext)  set to the handle of the server, NULL on failure
  * @param  hostname(string)                   hostname of the system where opcua server should run
  * @param  port(unsigned int)                 opcua port
  * @param  certificateFile(string)            server certificate file in .der format
  * @param  privateKeyFile(string)             server private key file in .der format
  * @param  trustedCerts(string array)         list of trusted certs
  * @param  trustedListSize(int)               count of trusted certs
+ * @param  notifyOnWrite(bool)                topics are value-backed variables written on publish
+ * @param  serverWorkers(size_t)              number of servers sharing the port, 0 or 1 for one
  * @return string "0" for success and other string for failure of the function */
 char*
-serverContextCreateSecured(const char *hostname,
+serverContextCreateSecured(struct ServerContext **serverContext,
+                    const char *hostname,
                     unsigned int port,
                     const char *certificateFile,
                     const char *privateKeyFile,
                     char **trustedCerts,
-                    size_t trustedListSize);
+                    size_t trustedListSize,
+                    bool notifyOnWrite,
+                    size_t serverWorkers);
 
 /**serverContextCreate function builds the server context and starts the opcua server in insecure mode
+ * @param  serverContext(struct ServerContext)  set to the handle of the server, NULL on failure
  * @param  hostname(string)                   hostname of the system where opcua server should run
  * @param  port(unsigned int)                 opcua port
+ * @param  notifyOnWrite(bool)                topics are value-backed variables written on publish
+ * @param  serverWorkers(size_t)              number of servers sharing the port, 0 or 1 for one
  * @return string "0" for success and other string for failure of the function */
 char*
-serverContextCreate(const char *hostname,
-                    unsigned int port);
+serverContextCreate(struct ServerContext **serverContext,
+                    const char *hostname,
+                    unsigned int port,
+                    bool notifyOnWrite,
+                    size_t serverWorkers);
 
 /**serverPublish creates the namespace if it doesn't exist, adds the opcua variable node (topic) 
  * in that namespace and writes **data** to the node
+ * @param  serverContext(struct)     handle of the server
  * @param  topicConfig(struct)       opcua `struct TopicConfig` structure
  * @param  data(string)              data to be written to opcua variable
  * @return string "0" for success and other string for failure of the function */
 char*
-serverPublish(struct TopicConfig topicConfig,
+serverPublish(struct ServerContext *serverContext,
+              struct TopicConfig topicConfig,
               const char *data);
 
-/** serverContextDestroy function destroys the opcua server context */
-void serverContextDestroy();
+/**serverPublishBytes publishes len bytes of binary data buf to the topic as a ByteString,
+ * creating the namespace and the topic if they don't exist. A topic keeps the data type of
+ * its first publish, so it can't be published to with both serverPublish and serverPublishBytes
+ * @param  serverContext(struct)     handle of the server
+ * @param  topicConfig(struct)       opcua `struct TopicConfig` structure
+ * @param  buf(array)                data to be written to opcua variable
+ * @param  len(size_t)               length of buf in bytes, less than PUBLISH_DATA_SIZE
+ * @return string "0" for success and other string for failure of the function */
+char*
+serverPublishBytes(struct ServerContext *serverContext,
+                   struct TopicConfig topicConfig,
+                   const uint8_t *buf,
+                   size_t len);
+
+/**serverPublishValues publishes count values of the type selected by topicConfig.dType to the
+ * topic, creating the namespace and the topic if they don't exist. values is a C array of bool,
+ * int32_t, int64_t, float, double or UA_DateTime (int64_t) for boolean, int32 (int), int64, float,
+ * double and datetime topics. Scalar topics take exactly one value, array topics any number
+ * @param  serverContext(struct)     handle of the server
+ * @param  topicConfig(struct)       opcua `struct TopicConfig` structure
+ * @param  values(array)             values to be written to opcua variable
+ * @param  count(size_t)             number of values
+ * @return string "0" for success and other string for failure of the function */
+char*
+serverPublishValues(struct ServerContext *serverContext,
+                    struct TopicConfig topicConfig,
+                    const void *values,
+                    size_t count);
+
+/**serverPublishBatch publishes data[i] of lens[i] bytes to the topic topicConfigs[i] for all
+ * count topics at once, creating the namespaces and topics that don't exist. Nothing is
+ * published if it fails for any of the topics
+ * @param  serverContext(struct)     handle of the server
+ * @param  topicConfigs(array)       array of `struct TopicConfig` structure instances
+ * @param  data(array)               data to be written to each opcua variable
+ * @param  lens(array)               length of each data in bytes
+ * @param  count(size_t)             number of topics
+ * @return string "0" for success and other string for failure of the function */
+char*
+serverPublishBatch(struct ServerContext *serverContext,
+                   struct TopicConfig *topicConfigs,
+                   const char **data,
+                   const size_t *lens,
+                   size_t count);
+
+/** Payload is an immutable, reference-counted buffer holding the value of a topic. Once
+ * published, it is shared as-is by the topics it was published to and by their reads and
+ * samples until it is replaced, only the samples a monitored item keeps are copied, so it
+ * must not be modified after being published */
+struct Payload;
+
+/**payloadNew allocates a payload of length bytes with a reference count of one
+ * @param  length(size_t)            size of the payload in bytes, less than PUBLISH_DATA_SIZE
+ * @return payload on success and NULL on failure */
+struct Payload*
+payloadNew(size_t length);
+
+/**payloadData returns the buffer of the payload, to be filled in before it is published */
+char*
+payloadData(struct Payload *payload);
+
+/**payloadRetain adds a reference to the payload */
+void
+payloadRetain(struct Payload *payload);
+
+/**payloadRelease drops a reference to the payload and frees it with the last one */
+void
+payloadRelease(struct Payload *payload);
+
+/**serverPublishPayload publishes payload to the topic without copying it, the caller's
+ * reference to payload is handed over to the topic even on failure
+ * @param  serverContext(struct)     handle of the server
+ * @param  topicConfig(struct)       opcua `struct TopicConfig` structure
+ * @param  payload(struct Payload)   payload created with payloadNew
+ * @return string "0" for success and other string for failure of the function */
+char*
+serverPublishPayload(struct ServerContext *serverContext,
+                     struct TopicConfig topicConfig,
+                     struct Payload *payload);
+
+/** ServerMetrics are the server wide metrics of a server, summed over its worker pool */
+struct ServerMetrics {
+    uint64_t topicCount;            ///< topics published to, the diagnostics ones excepted
+    uint64_t currentChannelCount;   ///< open secure channels
+    uint64_t cumulatedChannelCount; ///< secure channels opened since the server started
+    uint64_t rejectedChannelCount;  ///< secure channels rejected
+    uint64_t currentSessionCount;   ///< open sessions
+    uint64_t cumulatedSessionCount; ///< sessions created since the server started
+    uint64_t rejectedSessionCount;  ///< sessions rejected
+    uint64_t sessionTimeoutCount;   ///< sessions closed on timeout
+    uint64_t sessionAbortCount;     ///< sessions aborted
+    uint64_t registryLockWaits;     ///< acquisitions of the topic registry lock that had to wait for it
+    uint64_t registryLockWaitNs;    ///< total time they waited
+};
+
+/** TopicMetrics are the publish metrics of a topic. The latency of a publish call is counted for
+ * each of its topics, its quantiles are those of an HDR histogram, precise to 1/8 of the value */
+struct TopicMetrics {
+    char ns[NAMESPACE_SIZE];        ///< opcua namespace name, truncated to NAMESPACE_SIZE - 1
+    char topic[TOPIC_SIZE];         ///< opcua topic name, truncated to TOPIC_SIZE - 1
+    uint64_t publishCount;          ///< values published
+    uint64_t publishBytes;          ///< bytes of the values published
+    uint64_t drops;                 ///< values replaced by the next one before a server thread took them
+    uint64_t latencySumNs;          ///< total time of the publish calls
+    uint64_t latencyMaxNs;          ///< longest publish call
+    uint64_t latencyP50Ns;          ///< median of the publish calls
+    uint64_t latencyP90Ns;
+    uint64_t latencyP99Ns;
+    uint64_t latencyP999Ns;
+};
+
+/**serverMetrics function gets the server wide metrics of the server
+ * @param  serverContext(struct)          handle of the server
+ * @param  metrics(struct ServerMetrics)  set to the metrics of the server
+ * @return string "0" for success and other string for failure of the function */
+char*
+serverMetrics(struct ServerContext *serverContext,
+              struct ServerMetrics *metrics);
+
+/**serverTopicMetrics function gets the publish metrics of the topics of the server, the diagnostics
+ * ones excepted, in no particular order
+ * @param  serverContext(struct)          handle of the server
+ * @param  metrics(array)                 set to the metrics of the first size topics
+ * @param  size(size_t)                   length of metrics array
+ * @param  count(size_t)                  set to the number of topics, which may exceed size
+ * @return string "0" for success and other string for failure of the function */
+char*
+serverTopicMetrics(struct ServerContext *serverContext,
+                   struct TopicMetrics *metrics,
+                   size_t size,
+                   size_t *count);
+
+/**serverPublishMetrics function mirrors the metrics of the server to int64 variables of the Diagnostics
+ * folder of DIAGNOSTICS_NAMESPACE: server.<ServerMetrics field> and <ns>.<topic>.<TopicMetrics field>
+ * @param  serverContext(struct)     handle of the server
+ * @return string "0" for success and other string for failure of the function */
+char*
+serverPublishMetrics(struct ServerContext *serverContext);
+
+/** serverContextDestroy function stops the opcua server and destroys its context */
+void serverContextDestroy(struct ServerContext *serverContext);
 
 //*************open62541 client wrappers**********************
 
 typedef void (*c_callback)(const char *topic, const char *data, void *pyxFunc);
 
+/** SubscribedData is a view into a notification of a subscribed topic. It points into the
+ * decoded notification without copying it, so it is only valid during the callback */
+struct SubscribedData {
+    const char *ns;             ///< opcua namespace name of the topic
+    const char *topic;          ///< opcua topic name
+    const char *dType;          ///< type of data: string|bytes|boolean|int32|int64|float|double|datetime,
+                                ///< NULL if the value is empty or of another opcua data type
+    bool isArray;               ///< data is an array of count values of dType
+    const void *data;           ///< string and bytes topics: the bytes, not NUL terminated
+                                ///< value topics: C array of bool, int32_t, int64_t, float, double
+                                ///< or UA_DateTime (int64_t) values, NULL if length is 0
+    size_t length;              ///< length of data in bytes
+    size_t count;               ///< number of values, 1 for scalars, strings and bytes
+    int64_t sourceTimestamp;    ///< UA_DateTime the value was published at, 0 if not sent
+    int64_t serverTimestamp;    ///< UA_DateTime the server sampled the value at, 0 if not sent
+    uint32_t statusCode;        ///< opcua status code of the value, 0 (Good) if not sent
+    size_t topicIndex;          ///< index of the topic in the subscribed topicConfigs array
+};
+
+typedef void (*c_data_callback)(const struct SubscribedData *data, void *userFunc);
+
+/** DispatchCounters are the counters of the dispatch queue of a subscribed topic. The client thread
+ * never waits for a full queue: the latest notification waits behind it, replacing the one waiting
+ * there, which is counted as dropped */
+struct DispatchCounters {
+    uint64_t enqueued;          ///< notifications queued by the client thread
+    uint64_t dispatched;        ///< notifications handed to the callback by the dispatch worker
+    uint64_t dropped;           ///< notifications replaced by a newer one while the queue was full
+    uint64_t depth;             ///< notifications waiting in the queue
+    uint64_t maxDepth;          ///< highest depth seen
+    uint64_t latencySumNs;      ///< total time the dispatched notifications waited in the queue
+    uint64_t latencyMaxNs;      ///< longest time a dispatched notification waited in the queue
+};
+
+/** ClientContext is the handle of an opcua client connection. Its callbacks are called on the
+ * client thread, or with dispatch workers on a pool of threads: the client thread then only
+ * decodes the notifications and queues them to the worker of their topic, so that slow callbacks
+ * don't hold back the keepalives and the publish responses of the subscription */
+struct ClientContext;
+
 /**clientContextCreateSecured function establishes secure connection with the opcua server
+ * @param  clientContext(struct ClientContext)  set to the handle of the client, NULL on failure
  * @param  hostname(string)           hostname of the system where opcua server is running
  * @param  port(uint)                 opcua port
  * @param  certificateFile(string)    client certificate file in .der format
  * @param  privateKeyFile(string)     client private key file in .der format
  * @param  trustedCerts(string array) list of trusted certs
  * @param  trustedListSize(int)       count of trusted certs
+ * @param  dispatchWorkers(size_t)    number of threads calling the callbacks, 0 for the client thread
  * @return string "0" for success and other string for failure of the function */
 char*
-clientContextCreateSecured(const char *hostname,
+clientContextCreateSecured(struct ClientContext **clientContext,
+                           const char *hostname,
                            unsigned int port,
                            const char *certificateFile,
                            const char *privateKeyFile,
                            char **trustedCerts,
-                           size_t trustedListSize);
+                           size_t trustedListSize,
+                           size_t dispatchWorkers);
 
 /**clientContextCreate function establishes unsecure connection with the opcua server
+ * @param  clientContext(struct ClientContext)  set to the handle of the client, NULL on failure
  * @param  hostname(string)           hostname of the system where opcua server is running
  * @param  port(int)                  opcua port
+ * @param  dispatchWorkers(size_t)    number of threads calling the callbacks, 0 for the client thread
  * @return string "0" for success and other string for failure of the function */
 char*
-clientContextCreate(const char *hostname,
-                    unsigned int port);
+clientContextCreate(struct ClientContext **clientContext,
+                    const char *hostname,
+                    unsigned int port,
+                    size_t dispatchWorkers);
 
-/**clientSubscribe function makes the subscription to the list of opcua variables (topics) in topicConfig array
+/**clientSubscribe function makes the subscription to the list of opcua variables (topics) in topicConfig array.
+ * cb gets a NUL terminated copy of the non empty values of string topics, see clientSubscribeData for the others
+ * @param  clientContext(struct)              handle of the client
  * @param  topicConfigs(array)                array of `struct TopicConfig` instances
  * @param  topicConfigCount(unsigned int)     length of topicConfigs array
  * @param  cb(c_callback)                     callback that sends out the subscribed data back to the caller
@@ -148,10 +370,92 @@ clientContextCreate(const char *hostname,
  *                                            For c and go callbacks, just puss NULL and nil respectively.
  * @return string "0" for success and other string for failure of the function */
 char*
-clientSubscribe(struct TopicConfig topicConfigs[],
+clientSubscribe(struct ClientContext *clientContext,
+                struct TopicConfig topicConfigs[],
                 unsigned int topicConfigCount,
                 c_callback cb,
                 void* pyxFunc);
 
-/**clientContextDestroy function destroys the opcua client context */
-void clientContextDestroy();
+/**clientSubscribeData function makes the subscription to the list of opcua variables (topics) in topicConfig
+ * array, handing each notification to cb as a `struct SubscribedData` view without copying it. Unlike
+ * clientSubscribe, every data type and empty values are delivered. cb is called on the client thread
+ * @param  clientContext(struct)              handle of the client
+ * @param  topicConfigs(array)                array of `struct TopicConfig` instances
+ * @param  topicConfigCount(unsigned int)     length of topicConfigs array
+ * @param  cb(c_data_callback)                callback that sends out the subscribed data back to the caller
+ * @param  userFunc                           passed back to cb as is, may be NULL
+ * @return string "0" for success and other string for failure of the function */
+char*
+clientSubscribeData(struct ClientContext *clientContext,
+                    struct TopicConfig topicConfigs[],
+                    unsigned int topicConfigCount,
+                    c_data_callback cb,
+                    void *userFunc);
+
+/**clientDispatchCounters function gets the counters of the dispatch queue of a subscribed topic
+ * @param  clientContext(struct)              handle of a client with dispatch workers
+ * @param  topicConfig(struct)                opcua `struct TopicConfig` structure of the topic
+ * @param  counters(struct DispatchCounters)  set to the counters of the topic
+ * @return string "0" for success and other string for failure of the function */
+char*
+clientDispatchCounters(struct ClientContext *clientContext,
+                       struct TopicConfig topicConfig,
+                       struct DispatchCounters *counters);
+
+/**clientContextDestroy function disconnects the opcua client and destroys its context */
+void clientContextDestroy(struct ClientContext *clientContext);
+
+/** NotificationRing is a bounded buffer the notifications of a subscription are copied into, for
+ * bindings that would rather drain them in batches than be called back for each one. Subscribe with
+ * notificationRingPush as the c_data_callback and the ring as its userFunc */
+struct NotificationRing;
+
+/** NotificationRecord is the header of a notification copied into a NotificationRing. It is followed
+ * by the length bytes of its data, padded so that the next record is 8 bytes aligned */
+struct NotificationRecord {
+    uint32_t size;              ///< size of the record in bytes, header and padded data
+    uint32_t topicIndex;        ///< index of the topic in the subscribed topicConfigs array
+    uint32_t statusCode;        ///< as in `struct SubscribedData`
+    uint32_t isArray;           ///< as in `struct SubscribedData`
+    uint64_t length;            ///< length of the data in bytes
+    uint64_t count;             ///< as in `struct SubscribedData`
+    int64_t sourceTimestamp;    ///< as in `struct SubscribedData`
+    int64_t serverTimestamp;    ///< as in `struct SubscribedData`
+    char dType[16];             ///< dType of `struct SubscribedData`, empty if NULL
+};
+
+/**notificationRingNew allocates a ring of capacity bytes
+ * @param  capacity(size_t)          size of the ring in bytes, notifications with bigger records are dropped
+ * @return ring on success and NULL on failure */
+struct NotificationRing*
+notificationRingNew(size_t capacity);
+
+/**notificationRingPush is the c_data_callback copying a notification into the ring passed as userFunc.
+ * It never blocks: if the ring is full the notification is dropped and counted */
+void
+notificationRingPush(const struct SubscribedData *data,
+                     void *userFunc);
+
+/**notificationRingDrain function waits for notifications and moves as many of them as fit into buf
+ * @param  ring(struct NotificationRing)   ring to drain
+ * @param  buf(array)                      set to the records of the notifications, oldest first
+ * @param  len(size_t)                     size of buf in bytes, the capacity of the ring always fits a record
+ * @param  written(size_t)                 set to the size of the records written to buf
+ * @param  dropped(uint64_t)               set to the notifications dropped since the last drain
+ * @return string "0" for success and other string for failure of the function, or once the ring is
+ *         closed and empty */
+char*
+notificationRingDrain(struct NotificationRing *ring,
+                      void *buf,
+                      size_t len,
+                      size_t *written,
+                      uint64_t *dropped);
+
+/**notificationRingClose wakes up and fails the drains of the ring once it is empty. Call it after
+ * the subscription is destroyed, nothing may be pushed afterwards */
+void
+notificationRingClose(struct NotificationRing *ring);
+
+/**notificationRingFree frees the ring, once nothing drains it anymore */
+void
+notificationRingFree(struct NotificationRing *ring);
@@ -5512,6 +5512,9 @@ struct UA_MonitoredItem {
     UA_UInt64 sampleCallbackId;
     UA_ByteString lastSampledValue;
     UA_DataValue lastValue;
+    /* EII patch 0001 */
+    UA_DateTime lastSampledWrite; /* Server timestamp of the node value at the
+                                   * last sample, 0 if it had none */
 
     /* Triggering Links */
     size_t triggeringLinksSize;
@@ -8001,17 +8004,35 @@ UA_findDataType(const UA_NodeId *typeId) {
 /* Random Number Generator */
 /***************************/
 
-//TODO is this safe for multithreading?
 static pcg32_random_t UA_rng = PCG32_INITIALIZER;
 
+/* EII patch 0003: the generator is shared by the servers and clients running
+ * on different threads of the process (nonces, session ids). Its state is
+ * updated under a spinlock, held only for the update. */
+#if defined(__GNUC__) || defined(__clang__)
+static char UA_rngLock;
+# define UA_RNG_LOCK() \
+    while(__atomic_test_and_set(&UA_rngLock, __ATOMIC_ACQUIRE)) {}
+# define UA_RNG_UNLOCK() __atomic_clear(&UA_rngLock, __ATOMIC_RELEASE)
+#else
+# define UA_RNG_LOCK()
+# define UA_RNG_UNLOCK()
+#endif
+
 void
 UA_random_seed(u64 seed) {
-    pcg32_srandom_r(&UA_rng, seed, (u64)UA_DateTime_now());
+    u64 initseq = (u64)UA_DateTime_now();
+    UA_RNG_LOCK();
+    pcg32_srandom_r(&UA_rng, seed, initseq);
+    UA_RNG_UNLOCK();
 }
 
 u32
 UA_UInt32_random(void) {
-    return (u32)pcg32_random_r(&UA_rng);
+    UA_RNG_LOCK();
+    u32 r = (u32)pcg32_random_r(&UA_rng);
+    UA_RNG_UNLOCK();
+    return r;
 }
 
 /*****************/
@@ -8173,16 +8194,17 @@ UA_Guid_equal(const UA_Guid *g1, const UA_Guid *g2) {
 UA_Guid
 UA_Guid_random(void) {
     UA_Guid result;
-    result.data1 = (u32)pcg32_random_r(&UA_rng);
-    u32 r = (u32)pcg32_random_r(&UA_rng);
+    /* EII patch 0003: draws through the locked generator */
+    result.data1 = UA_UInt32_random();
+    u32 r = UA_UInt32_random();
     result.data2 = (u16) r;
     result.data3 = (u16) (r >> 16);
-    r = (u32)pcg32_random_r(&UA_rng);
+    r = UA_UInt32_random();
     result.data4[0] = (u8)r;
     result.data4[1] = (u8)(r >> 4);
     result.data4[2] = (u8)(r >> 8);
     result.data4[3] = (u8)(r >> 12);
-    r = (u32)pcg32_random_r(&UA_rng);
+    r = UA_UInt32_random();
     result.data4[4] = (u8)r;
     result.data4[5] = (u8)(r >> 4);
     result.data4[6] = (u8)(r >> 8);
@@ -37376,12 +37398,11 @@ readValueAttributeFromDataSource(UA_Server *server, UA_Session *session,
              &vn->head.nodeId, vn->head.context,
              sourceTimeStamp, rangeptr, &v2);
     UA_LOCK(server->serviceMutex);
-    if(v2.hasValue && v2.value.storageType == UA_VARIANT_DATA_NODELETE) {
-        retval = UA_DataValue_copy(&v2, v);
-        UA_DataValue_clear(&v2);
-    } else {
-        *v = v2;
-    }
+    /* EII patch 0004: a value aliasing the data of the data source
+     * (UA_VARIANT_DATA_NODELETE) is not copied. It is valid until the server
+     * returns from the current service or sample, the values kept beyond that
+     * are copied by UA_Server_readWithSession and by the sample callback. */
+    *v = v2;
     return retval;
 }
 
@@ -37843,6 +37864,16 @@ UA_Server_readWithSession(UA_Server *server, UA_Session *session,
     /* Perform the read operation */
     ReadWithNode(node, server, session, timestampsToReturn, item, &dv);
 
+    /* EII patch 0004: the caller owns the returned value */
+    if(dv.hasValue && dv.value.storageType == UA_VARIANT_DATA_NODELETE) {
+        UA_Variant alias = dv.value;
+        if(UA_Variant_copy(&alias, &dv.value) != UA_STATUSCODE_GOOD) {
+            dv.hasValue = false;
+            dv.hasStatus = true;
+            dv.status = UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+    }
+
     /* Release the node and return */
     UA_NODESTORE_RELEASE(server, node);
     return dv;
@@ -40907,6 +40938,9 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session, UA_Subscri
     UA_MonitoringParameters_clear(&mon->parameters);
     mon->parameters = params;
 
+    /* EII patch 0001: the new filter may report an unchanged value differently */
+    mon->lastSampledWrite = 0;
+
     /* Re-register the callback if necessary */
     if(oldSamplingInterval != mon->parameters.samplingInterval) {
         UA_MonitoredItem_unregisterSampleCallback(server, mon);
@@ -58581,6 +58615,7 @@ UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
             UA_Notification_delete(server, notification);
         UA_ByteString_clear(&mon->lastSampledValue);
         UA_DataValue_clear(&mon->lastValue);
+        mon->lastSampledWrite = 0; /* EII patch 0001 */
         return UA_STATUSCODE_GOOD;
     }
 
@@ -58642,6 +58677,7 @@ UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon) {
     /* Remove the last samples */
     UA_ByteString_clear(&mon->lastSampledValue);
     UA_DataValue_clear(&mon->lastValue);
+    mon->lastSampledWrite = 0; /* EII patch 0001 */
 
     /* Add a delayed callback to remove the MonitoredItem when the current jobs
      * have completed. This is needed to allow that a local MonitoredItem can
@@ -59094,6 +59130,19 @@ sampleCallbackWithValue(UA_Server *server, UA_Session *session,
         return UA_STATUSCODE_GOOD;
     }
 
+    /* EII patch 0004: a sample aliasing the data of a data source is only
+     * valid during the sample. The value stored below keeps its own copy, so
+     * only the changed samples are copied. */
+    if(value->hasValue && value->value.storageType == UA_VARIANT_DATA_NODELETE) {
+        UA_Variant alias = value->value;
+        retval = UA_Variant_copy(&alias, &value->value);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_ByteString_clear(&binValueEncoding);
+            UA_DataValue_clear(value);
+            return retval;
+        }
+    }
+
     /* The MonitoredItem is attached to a subscription (not server-local).
      * Prepare a notification and enqueue it. */
     if(sub) {
@@ -59158,6 +59207,25 @@ monitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem)
     /* Get the node */
     const UA_Node *node = UA_NODESTORE_GET(server, &monitoredItem->itemToMonitor.nodeId);
 
+    /* EII patch 0001: every write of a value stored in the node sets its
+     * server timestamp. If the value was not written since the last sample,
+     * it has not changed and the read, the encoding and the comparison are
+     * skipped. Values coming from a data source, a value backend or an onRead
+     * callback are always sampled. */
+    UA_DateTime lastWrite = 0;
+    if(node && node->head.nodeClass == UA_NODECLASS_VARIABLE &&
+       monitoredItem->itemToMonitor.attributeId == UA_ATTRIBUTEID_VALUE &&
+       node->variableNode.valueBackend.backendType == UA_VALUEBACKENDTYPE_NONE &&
+       node->variableNode.valueSource == UA_VALUESOURCE_DATA &&
+       !node->variableNode.value.data.callback.onRead &&
+       node->variableNode.value.data.value.hasServerTimestamp) {
+        lastWrite = node->variableNode.value.data.value.serverTimestamp;
+        if(lastWrite != 0 && lastWrite == monitoredItem->lastSampledWrite) {
+            UA_NODESTORE_RELEASE(server, node);
+            return;
+        }
+    }
+
     /* Sample the value. The sample can still point into the node. */
     UA_DataValue value;
     UA_DataValue_init(&value);
@@ -59172,6 +59240,7 @@ monitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem)
     /* Operate on the sample. Don't touch value after this. */
     UA_StatusCode retval = sampleCallbackWithValue(server, session, sub,
                                                    monitoredItem, &value);
+    monitoredItem->lastSampledWrite = (retval == UA_STATUSCODE_GOOD) ? lastWrite : 0; /* EII patch 0001 */
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SUBSCRIPTION(&server->config.logger, sub,
                                     "MonitoredItem %" PRIi32 " | "
@@ -71019,6 +71088,7 @@ typedef struct {
     UA_UInt16 serverSocketsSize;
     LIST_HEAD(, ConnectionEntry) connections;
     UA_UInt16 connectionsSize;
+    UA_Boolean reusePort; /* EII patch 0002 */
 } ServerNetworkLayerTCP;
 
 static void
@@ -71161,6 +71231,25 @@ addServerSocket(ServerNetworkLayerTCP *layer, struct addrinfo *ai) {
         return UA_STATUSCODE_BADCOMMUNICATIONERROR;
     }
 
+    /* EII patch 0002: several servers of the process share the port, the
+     * kernel balances the incoming connections between them */
+    if(layer->reusePort) {
+#ifdef SO_REUSEPORT
+        if(UA_setsockopt(newsock, SOL_SOCKET, SO_REUSEPORT,
+                         (const char *)&optval, sizeof(optval)) == -1) {
+            UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
+                           "Could not make the socket port reusable");
+            UA_close(newsock);
+            return UA_STATUSCODE_BADCOMMUNICATIONERROR;
+        }
+#else
+        UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
+                       "Sharing the port is not supported");
+        UA_close(newsock);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+#endif
+    }
+
 
     if(UA_socket_set_nonblocking(newsock) != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING(layer->logger, UA_LOGCATEGORY_NETWORK,
@@ -71494,6 +71583,16 @@ UA_ServerNetworkLayerTCP(UA_ConnectionConfig config, UA_UInt16 port,
     return nl;
 }
 
+/* EII patch 0002 */
+UA_StatusCode
+UA_ServerNetworkLayerTCP_setReusePort(UA_ServerNetworkLayer *nl,
+                                      UA_Boolean reusePort) {
+    if(nl->start != ServerNetworkLayerTCP_start || !nl->handle)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    ((ServerNetworkLayerTCP *)nl->handle)->reusePort = reusePort;
+    return UA_STATUSCODE_GOOD;
+}
+
 typedef struct TCPClientConnection {
     struct addrinfo hints, *server;
     UA_DateTime connStart;
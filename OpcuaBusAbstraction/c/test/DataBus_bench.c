@@ -0,0 +1,649 @@
+/*
+Copyright (c) 2021 Intel Corporation.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/* Measures the publish to notification latency of the opcua bus.
+ * The process forks into a publisher (server) and subscribers (clients). Each
+ * published value carries its CLOCK_MONOTONIC publish time, the callback of
+ * the first subscriber computes the latency on arrival, the others only keep
+ * a subscription open. Every subscriber counts its notifications, their sum
+ * over the subscribers gives the notification throughput of the publisher. The
+ * publisher also reports the CPU it burns while idle with all the subscribers
+ * connected.
+ *
+ * The sweep mode runs the benchmark for every combination of payload size,
+ * topic count, publish rate and security mode, each one in a process of its
+ * own, and writes the results to a JSON file. */
+
+#define _DEFAULT_SOURCE 1
+
+#include "DataBus.h"
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define BENCH_NS "benchmark"
+#define BENCH_TOPIC "latency"
+#define BENCH_DTYPE "string"
+#define IDLE_SECONDS 2
+#define MAX_BENCH_TOPICS 64
+#define MAX_SWEEP_VALUES 16
+#define MIN_SWEEP_COUNT 100
+
+// parameters of a benchmark run
+typedef struct {
+    char *endpoint;
+    long count;             // number of values published over all the topics
+    long intervalUs;        // time between two publishes
+    long clients;           // number of subscribers, the first one measures the latency
+    size_t payloadBytes;    // size of the published values
+    long topics;            // number of topics the values are published to in turn
+    long idleSeconds;       // time the publisher idle CPU is measured for, 0 to skip it
+    bool notifyOnWrite;
+    size_t serverWorkers;
+    size_t dispatchWorkers;
+    /* all empty for an insecure run, otherwise the publisher runs with the server
+     * certificate and trusts the client one and the subscribers the other way round */
+    char *serverCert;
+    char *serverKey;
+    char *clientCert;
+    char *clientKey;
+} bench_config_t;
+
+// results of a benchmark run, latencies in nanoseconds
+typedef struct {
+    long received;
+    long long latencyMin;
+    long long latencyP50;
+    long long latencyP99;
+    long long latencyP999;
+    long long latencyMax;
+    double latencyMean;
+    long notifications;     // over all the subscribers
+    double notificationRate;
+    double publishRate;     // achieved by the publisher
+    double idleCpu;         // percent of a core
+} bench_result_t;
+
+// measures of the publisher sent back to the measuring process
+typedef struct {
+    double publishRate;
+    double idleCpu;
+} publisher_result_t;
+
+// notifications received by a subscriber and the time of the first and last one
+typedef struct {
+    long count;
+    long long firstNs;
+    long long lastNs;
+} notifications_t;
+
+static bench_config_t gConfig;
+static struct TopicConfig gTopics[MAX_BENCH_TOPICS];
+static char gTopicNames[MAX_BENCH_TOPICS][TOPIC_SIZE];
+static long long *gLatencies;
+static long gReceived;
+static notifications_t gNotifications;
+/* the callbacks of different topics may run on different dispatch workers */
+static pthread_mutex_t gNotificationsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static long long nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static int compareLatency(const void *a, const void *b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static void cb(const struct SubscribedData *data, void *userFunc) {
+    long long now = nowNs();
+    long long published = 0;
+    long seq = -1;
+    /* the data is a view into the notification, scan a NUL terminated copy of its head */
+    char head[100];
+    size_t len = data->length < sizeof(head) ? data->length : sizeof(head) - 1;
+    if (data->data == NULL) {
+        return;
+    }
+    memcpy(head, data->data, len);
+    head[len] = '\0';
+    if (sscanf(head, "%*s %ld %lld", &seq, &published) != 2 || seq < 0) {
+        return;
+    }
+    pthread_mutex_lock(&gNotificationsLock);
+    if (gNotifications.count++ == 0) {
+        gNotifications.firstNs = now;
+    }
+    gNotifications.lastNs = now;
+    if (gLatencies != NULL && gReceived < gConfig.count) {
+        gLatencies[gReceived++] = now - published;
+    }
+    pthread_mutex_unlock(&gNotificationsLock);
+}
+
+static bool secure(const bench_config_t *config) {
+    return config->serverCert[0] != '\0';
+}
+
+static void initConfigs(struct ContextConfig *contextConfig, char *direction) {
+    static char *trustFiles[1];
+    bool pub = !strcmp(direction, "PUB");
+    contextConfig->endpoint = gConfig.endpoint;
+    contextConfig->direction = direction;
+    contextConfig->certFile = pub ? gConfig.serverCert : gConfig.clientCert;
+    contextConfig->privateFile = pub ? gConfig.serverKey : gConfig.clientKey;
+    trustFiles[0] = pub ? gConfig.clientCert : gConfig.serverCert;
+    contextConfig->trustFile = trustFiles;
+    contextConfig->trustedListSize = 1;
+    contextConfig->notifyOnWrite = gConfig.notifyOnWrite;
+    contextConfig->serverWorkers = gConfig.serverWorkers;
+    contextConfig->dispatchWorkers = gConfig.dispatchWorkers;
+    for (long i = 0; i < gConfig.topics; i++) {
+        snprintf(gTopicNames[i], TOPIC_SIZE, "%s%ld", BENCH_TOPIC, i);
+        gTopics[i].ns = BENCH_NS;
+        gTopics[i].name = gTopicNames[i];
+        gTopics[i].dType = BENCH_DTYPE;
+    }
+}
+
+/* Writes the value "<topic> <seq> <publish time> <padding>" of at least
+ * payloadBytes bytes to data */
+static void formatValue(char *data, const char *topic, long seq, long long published,
+                        size_t payloadBytes) {
+    int len = sprintf(data, "%s %ld %lld ", topic, seq, published);
+    if ((size_t)len < payloadBytes) {
+        memset(data + len, 'x', payloadBytes - len);
+        data[payloadBytes] = '\0';
+    }
+}
+
+static int runPublisher(int readyFd, int subscribedFd, int resultFd) {
+    struct ContextConfig contextConfig;
+    publisher_result_t result = {0};
+    char sync;
+    char *data = (char*) malloc(gConfig.payloadBytes + 100);
+    if (data == NULL) {
+        return -1;
+    }
+
+    initConfigs(&contextConfig, "PUB");
+    struct DataBusContext *context;
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    if (strcmp(errorMsg, "0")) {
+        fprintf(stderr, "ContextCreate() API failed, error: %s\n", errorMsg);
+        return -1;
+    }
+    /* the topics have to exist before the subscribers look them up */
+    for (long i = 0; i < gConfig.topics; i++) {
+        formatValue(data, gTopics[i].name, -1, 0, gConfig.payloadBytes);
+        errorMsg = Publish(context, gTopics[i], data);
+        if (strcmp(errorMsg, "0")) {
+            fprintf(stderr, "Publish() API failed, error: %s\n", errorMsg);
+            return -1;
+        }
+    }
+    for (long i = 0; i < gConfig.clients; i++) {
+        if (write(readyFd, "r", 1) != 1) {
+            return -1;
+        }
+    }
+    for (long i = 0; i < gConfig.clients; i++) {
+        if (read(subscribedFd, &sync, 1) != 1) {
+            return -1;
+        }
+    }
+    sleep(1);
+
+    /* publish on a fixed schedule, a late publish doesn't delay the next ones */
+    long long start = nowNs();
+    for (long i = 0; i < gConfig.count; i++) {
+        long long due = start + i * gConfig.intervalUs * 1000LL;
+        struct timespec ts = {due / 1000000000LL, due % 1000000000LL};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        struct TopicConfig topic = gTopics[i % gConfig.topics];
+        formatValue(data, topic.name, i, nowNs(), gConfig.payloadBytes);
+        errorMsg = Publish(context, topic, data);
+        if (strcmp(errorMsg, "0")) {
+            fprintf(stderr, "Publish() API failed, error: %s\n", errorMsg);
+            return -1;
+        }
+    }
+    long long elapsed = nowNs() - start;
+    result.publishRate = elapsed > 0 ? gConfig.count * 1e9 / elapsed : 0;
+
+    if (gConfig.idleSeconds > 0) {
+        double cpuStart = cpuSeconds();
+        sleep(gConfig.idleSeconds);
+        result.idleCpu = (cpuSeconds() - cpuStart) * 100.0 / gConfig.idleSeconds;
+    }
+    if (write(resultFd, &result, sizeof(result)) != sizeof(result)) {
+        return -1;
+    }
+
+    /* wait for the measuring subscriber to be done */
+    if (read(subscribedFd, &sync, 1) < 0) {
+        return -1;
+    }
+    ContextDestroy(context);
+    free(data);
+    return 0;
+}
+
+/* Rate of the notifications of a subscriber, 0 for less than two */
+static double notificationRate(const notifications_t *notifications) {
+    if (notifications->count < 2 || notifications->lastNs <= notifications->firstNs) {
+        return 0;
+    }
+    return (notifications->count - 1) * 1e9 / (notifications->lastNs - notifications->firstNs);
+}
+
+static struct DataBusContext *subscribe(int readyFd, int subscribedFd) {
+    struct ContextConfig contextConfig;
+    char sync;
+
+    if (read(readyFd, &sync, 1) != 1) {
+        return NULL;
+    }
+    initConfigs(&contextConfig, "SUB");
+    struct DataBusContext *context;
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    if (strcmp(errorMsg, "0")) {
+        fprintf(stderr, "ContextCreate() API failed, error: %s\n", errorMsg);
+        return NULL;
+    }
+    errorMsg = SubscribeData(context, gTopics, gConfig.topics, "START", cb, NULL);
+    if (strcmp(errorMsg, "0")) {
+        fprintf(stderr, "SubscribeData() API failed, error: %s\n", errorMsg);
+        ContextDestroy(context);
+        return NULL;
+    }
+    if (write(subscribedFd, "s", 1) != 1) {
+        ContextDestroy(context);
+        return NULL;
+    }
+    return context;
+}
+
+/* Keeps a subscription open until quitFd is closed, then writes its
+ * notifications to resultFd */
+static int runIdleSubscriber(int readyFd, int subscribedFd, int quitFd, int resultFd) {
+    char sync;
+    struct DataBusContext *context = subscribe(readyFd, subscribedFd);
+    if (context == NULL) {
+        return -1;
+    }
+    /* returns on EOF */
+    while (read(quitFd, &sync, 1) > 0) {
+    }
+    ContextDestroy(context);
+    pthread_mutex_lock(&gNotificationsLock);
+    notifications_t notifications = gNotifications;
+    pthread_mutex_unlock(&gNotificationsLock);
+    if (write(resultFd, &notifications, sizeof(notifications)) != sizeof(notifications)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int runSubscriber(int readyFd, int subscribedFd, bench_result_t *result) {
+    gLatencies = (long long*) calloc(gConfig.count, sizeof(long long));
+    if (gLatencies == NULL) {
+        return -1;
+    }
+    struct DataBusContext *context = subscribe(readyFd, subscribedFd);
+    if (context == NULL) {
+        return -1;
+    }
+
+    /* publishing time, the publisher's idle time and some slack */
+    long long deadline = nowNs() + (1 + gConfig.idleSeconds + 2) * 1000000000LL +
+                         gConfig.count * (gConfig.intervalUs + 100) * 1000LL;
+    long received = 0;
+    while (received < gConfig.count && nowNs() < deadline) {
+        usleep(10000);
+        pthread_mutex_lock(&gNotificationsLock);
+        received = gReceived;
+        pthread_mutex_unlock(&gNotificationsLock);
+    }
+    if (write(subscribedFd, "d", 1) != 1) {
+        return -1;
+    }
+    ContextDestroy(context);
+
+    result->received = gReceived;
+    if (gReceived > 0) {
+        received = gReceived;
+        qsort(gLatencies, received, sizeof(long long), compareLatency);
+        long long sum = 0;
+        for (long i = 0; i < received; i++) {
+            sum += gLatencies[i];
+        }
+        result->latencyMin = gLatencies[0];
+        result->latencyP50 = gLatencies[received / 2];
+        result->latencyP99 = gLatencies[(received * 99) / 100];
+        result->latencyP999 = gLatencies[(received * 999) / 1000];
+        result->latencyMax = gLatencies[received - 1];
+        result->latencyMean = (double)sum / received;
+    }
+    free(gLatencies);
+    gLatencies = NULL;
+    return result->received > 0 ? 0 : -1;
+}
+
+/* Runs the benchmark of config: forks the publisher and the idle subscribers and
+ * measures the latency in this process */
+static int runBenchmark(const bench_config_t *config, bench_result_t *result) {
+    int readyPipe[2];
+    int subscribedPipe[2];
+    int quitPipe[2];
+    int resultPipe[2];
+    int publisherPipe[2];
+    if (pipe(readyPipe) || pipe(subscribedPipe) || pipe(quitPipe) || pipe(resultPipe) ||
+        pipe(publisherPipe)) {
+        fprintf(stderr, "pipe creation failed\n");
+        return -1;
+    }
+    gConfig = *config;
+    memset(result, 0, sizeof(*result));
+
+    pid_t *pids = (pid_t*) calloc(config->clients, sizeof(pid_t));
+    if (pids == NULL) {
+        return -1;
+    }
+    fflush(stdout);
+    /* pids[0] is the publisher, the others the idle subscribers */
+    for (long i = 0; i < config->clients; i++) {
+        pids[i] = fork();
+        if (pids[i] < 0) {
+            fprintf(stderr, "fork failed\n");
+            exit(-1);
+        }
+        if (pids[i] == 0) {
+            close(quitPipe[1]);
+            if (i == 0) {
+                /* publisher reads subscriber notifications from subscribedPipe */
+                exit(runPublisher(readyPipe[1], subscribedPipe[0], publisherPipe[1]) ? 1 : 0);
+            }
+            exit(runIdleSubscriber(readyPipe[0], subscribedPipe[1], quitPipe[0], resultPipe[1]) ? 1 : 0);
+        }
+    }
+
+    int ret = runSubscriber(readyPipe[0], subscribedPipe[1], result);
+    notifications_t notifications = gNotifications;
+    result->notifications = notifications.count;
+    result->notificationRate = notificationRate(&notifications);
+    int status;
+    if (ret) {
+        kill(pids[0], SIGTERM);
+    }
+    waitpid(pids[0], &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+        ret = -1;
+    }
+    close(publisherPipe[1]);
+    publisher_result_t publisher;
+    if (read(publisherPipe[0], &publisher, sizeof(publisher)) == sizeof(publisher)) {
+        result->publishRate = publisher.publishRate;
+        result->idleCpu = publisher.idleCpu;
+    }
+    /* let the idle subscribers go */
+    close(quitPipe[1]);
+    for (long i = 1; i < config->clients; i++) {
+        waitpid(pids[i], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+            ret = -1;
+        }
+    }
+    close(resultPipe[1]);
+    while (read(resultPipe[0], &notifications, sizeof(notifications)) == sizeof(notifications)) {
+        result->notifications += notifications.count;
+        result->notificationRate += notificationRate(&notifications);
+    }
+    int fds[] = {readyPipe[0], readyPipe[1], subscribedPipe[0], subscribedPipe[1], quitPipe[0],
+                 resultPipe[0], publisherPipe[0]};
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        close(fds[i]);
+    }
+    free(pids);
+    return ret;
+}
+
+/* Runs the benchmark of config in a child process, so that every run of a sweep
+ * starts from a fresh process */
+static int runIsolated(const bench_config_t *config, bench_result_t *result) {
+    int resultPipe[2];
+    if (pipe(resultPipe)) {
+        return -1;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        return -1;
+    }
+    if (pid == 0) {
+        close(resultPipe[0]);
+        int ret = runBenchmark(config, result);
+        if (write(resultPipe[1], result, sizeof(*result)) != sizeof(*result)) {
+            ret = -1;
+        }
+        exit(ret ? 1 : 0);
+    }
+    close(resultPipe[1]);
+    memset(result, 0, sizeof(*result));
+    ssize_t len = read(resultPipe[0], result, sizeof(*result));
+    close(resultPipe[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    return len == sizeof(*result) && WIFEXITED(status) && !WEXITSTATUS(status) ? 0 : -1;
+}
+
+/* Parses the comma separated list of positive numbers list into values,
+ * returns their number, 0 on error */
+static size_t parseList(const char *list, long values[MAX_SWEEP_VALUES]) {
+    size_t count = 0;
+    const char *next = list;
+    while (count < MAX_SWEEP_VALUES) {
+        char *end;
+        values[count] = strtol(next, &end, 10);
+        if (end == next || values[count] <= 0 || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+        count++;
+        if (*end == '\0') {
+            return count;
+        }
+        next = end + 1;
+    }
+    return 0;
+}
+
+static void writeResult(FILE *out, const bench_config_t *config, long rate, int ret,
+                        const bench_result_t *result) {
+    fprintf(out, "    {\"security\": \"%s\", \"payload_bytes\": %zu, \"topics\": %ld, \"rate_hz\": %ld, "
+            "\"clients\": %ld, \"ok\": %s,\n", secure(config) ? "SignAndEncrypt" : "None",
+            config->payloadBytes, config->topics, rate, config->clients, ret ? "false" : "true");
+    fprintf(out, "     \"published\": %ld, \"received\": %ld, \"publish_rate_hz\": %.1f, "
+            "\"notifications\": %ld, \"notifications_per_s\": %.1f, \"throughput_bytes_per_s\": %.0f,\n",
+            config->count, result->received, result->publishRate, result->notifications,
+            result->notificationRate, result->notificationRate * config->payloadBytes);
+    fprintf(out, "     \"latency_us\": {\"min\": %.1f, \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, "
+            "\"max\": %.1f, \"mean\": %.1f}}",
+            result->latencyMin / 1e3, result->latencyP50 / 1e3, result->latencyP99 / 1e3,
+            result->latencyP999 / 1e3, result->latencyMax / 1e3, result->latencyMean / 1e3);
+}
+
+/* Runs the benchmark for every combination of the payload sizes, topic counts, publish rates and
+ * security modes, seconds of publishing each, and writes the results to the JSON file outFile */
+static int runSweep(char *endpoint, char *outFile, char *payloadList, char *topicList, char *rateList,
+                    long seconds, long clients, char **certs) {
+    long payloads[MAX_SWEEP_VALUES];
+    long topics[MAX_SWEEP_VALUES];
+    long rates[MAX_SWEEP_VALUES];
+    size_t payloadCount = parseList(payloadList, payloads);
+    size_t topicCount = parseList(topicList, topics);
+    size_t rateCount = parseList(rateList, rates);
+    if (payloadCount == 0 || topicCount == 0 || rateCount == 0 || seconds <= 0 || clients <= 0) {
+        fprintf(stderr, "Invalid sweep arguments\n");
+        return -1;
+    }
+    for (size_t i = 0; i < payloadCount; i++) {
+        if (payloads[i] >= PUBLISH_DATA_SIZE) {
+            fprintf(stderr, "Payload size %ld is not less than %d\n", payloads[i], PUBLISH_DATA_SIZE);
+            return -1;
+        }
+    }
+    for (size_t i = 0; i < topicCount; i++) {
+        if (topics[i] > MAX_BENCH_TOPICS) {
+            fprintf(stderr, "Topic count %ld is more than %d\n", topics[i], MAX_BENCH_TOPICS);
+            return -1;
+        }
+    }
+    FILE *out = fopen(outFile, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Failed to open %s\n", outFile);
+        return -1;
+    }
+
+    char *insecure[] = {"", "", "", ""};
+    char **securities[] = {insecure, certs};
+    size_t securityCount = certs != NULL ? 2 : 1;
+    fprintf(out, "{\n  \"endpoint\": \"%s\",\n  \"open62541\": \"%s\",\n  \"seconds\": %ld,\n"
+            "  \"notify_on_write\": false,\n  \"runs\": [\n", endpoint, UA_OPEN62541_VER_COMMIT, seconds);
+    /* the runs are forked, don't leave them a buffered copy to flush */
+    fflush(out);
+    int ret = 0;
+    bool first = true;
+    for (size_t s = 0; s < securityCount; s++) {
+        for (size_t p = 0; p < payloadCount; p++) {
+            for (size_t t = 0; t < topicCount; t++) {
+                for (size_t r = 0; r < rateCount; r++) {
+                    bench_config_t config = {
+                        .endpoint = endpoint,
+                        .count = rates[r] * seconds,
+                        .intervalUs = 1000000 / rates[r],
+                        .clients = clients,
+                        .payloadBytes = payloads[p],
+                        .topics = topics[t],
+                        .serverWorkers = 1,
+                        .serverCert = securities[s][0],
+                        .serverKey = securities[s][1],
+                        .clientCert = securities[s][2],
+                        .clientKey = securities[s][3],
+                    };
+                    if (config.count < MIN_SWEEP_COUNT) {
+                        config.count = MIN_SWEEP_COUNT;
+                    }
+                    fprintf(stderr, "sweep: %s payload %zu topics %ld rate %ld/s\n",
+                            secure(&config) ? "SignAndEncrypt" : "None", config.payloadBytes,
+                            config.topics, rates[r]);
+                    bench_result_t result;
+                    int runRet = runIsolated(&config, &result);
+                    if (runRet) {
+                        ret = -1;
+                    }
+                    fprintf(out, first ? "" : ",\n");
+                    writeResult(out, &config, rates[r], runRet, &result);
+                    fflush(out);
+                    first = false;
+                }
+            }
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+    return ret;
+}
+
+static void usage() {
+    printf("Usage: <program> <endpoint> <count> <interval_us> [clients] [payload_bytes] \
+[notify_on_write] [server_workers] [dispatch_workers] where \n \
+                endpoint: opcua://localhost:65003 \n \
+                count: number of values to publish \n \
+                interval_us: time between two publishes in microseconds \n \
+                clients: number of subscribers, default 1 \n \
+                payload_bytes: size of the published values, default 0 (only the header) \n \
+                notify_on_write: 1 for value-backed topic variables, default 0 \n \
+                server_workers: number of servers sharing the port, default 1 \n \
+                dispatch_workers: number of threads calling the subscriber callbacks, default 0\n");
+    printf("   or: <program> sweep <endpoint> <output_json> <payload_bytes> <topics> <rates> [seconds] \
+[clients] [server_cert server_key client_cert client_key] where \n \
+                payload_bytes, topics, rates: comma separated values to sweep, ex: 100,1000,60000 \n \
+                seconds: publishing time of each run, default 2 \n \
+                clients: number of subscribers, default 1 \n \
+                certs: DER certificates and keys, also sweeps the SignAndEncrypt security mode\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && !strcmp(argv[1], "sweep")) {
+        if (argc < 7 || (argc > 9 && argc != 13)) {
+            usage();
+            exit(-1);
+        }
+        long seconds = (argc > 7) ? atol(argv[7]) : 2;
+        long clients = (argc > 8) ? atol(argv[8]) : 1;
+        return runSweep(argv[2], argv[3], argv[4], argv[5], argv[6], seconds, clients,
+                        argc == 13 ? &argv[9] : NULL) ? -1 : 0;
+    }
+    if (argc < 4) {
+        usage();
+        exit(-1);
+    }
+    bench_config_t config = {
+        .endpoint = argv[1],
+        .count = atol(argv[2]),
+        .intervalUs = atol(argv[3]),
+        .clients = (argc > 4) ? atol(argv[4]) : 1,
+        .topics = 1,
+        .idleSeconds = IDLE_SECONDS,
+        .notifyOnWrite = (argc > 6) && atoi(argv[6]) != 0,
+        .serverCert = "",
+        .serverKey = "",
+        .clientCert = "",
+        .clientKey = "",
+    };
+    long payloadBytes = (argc > 5) ? atol(argv[5]) : 0;
+    long serverWorkers = (argc > 7) ? atol(argv[7]) : 1;
+    long dispatchWorkers = (argc > 8) ? atol(argv[8]) : 0;
+    if (config.count <= 0 || config.intervalUs < 0 || config.clients <= 0 || payloadBytes < 0 ||
+        payloadBytes >= PUBLISH_DATA_SIZE || serverWorkers <= 0 || dispatchWorkers < 0) {
+        fprintf(stderr, "Invalid arguments\n");
+        exit(-1);
+    }
+    config.payloadBytes = payloadBytes;
+    config.serverWorkers = serverWorkers;
+    config.dispatchWorkers = dispatchWorkers;
+
+    bench_result_t result;
+    int ret = runBenchmark(&config, &result);
+    printf("publisher idle cpu: %.2f%% (%.2f%% per client)\n", result.idleCpu, result.idleCpu / config.clients);
+    printf("received: %ld/%ld\n", result.received, config.count);
+    if (result.received > 0) {
+        printf("latency us: min %.1f p50 %.1f p99 %.1f p99.9 %.1f max %.1f mean %.1f\n",
+               result.latencyMin / 1e3, result.latencyP50 / 1e3, result.latencyP99 / 1e3,
+               result.latencyP999 / 1e3, result.latencyMax / 1e3, result.latencyMean / 1e3);
+    }
+    printf("notifications: %ld over %ld clients and %ld server workers, %.0f/s (%.0f/s per client)\n",
+           result.notifications, config.clients, serverWorkers, result.notificationRate,
+           result.notificationRate / config.clients);
+    return ret ? -1 : 0;
+}
@@ -58,6 +58,7 @@ int main(int argc, char **argv) {
     }
 
     char *errorMsg;
+    struct DataBusContext *context;
     contextConfig.direction = argv[1];
     contextConfig.endpoint = argv[2];
     char *namespace = argv[3];
@@ -110,7 +111,7 @@ int main(int argc, char **argv) {
 		topic = strtok(NULL, delim);
 	}
 
-    errorMsg = ContextCreate(contextConfig);
+    errorMsg = ContextCreate(contextConfig, &context);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
         return -1;
@@ -123,7 +124,7 @@ int main(int argc, char **argv) {
             for (int j = 0; j < totalTopics; j++) {
                 if (topicConfigs[j].name != NULL) {
                     sprintf(result, "%s %d", topicConfigs[j].name, i);
-                    errorMsg = Publish(topicConfigs[j], result);
+                    errorMsg = Publish(context, topicConfigs[j], result);
                     if(strcmp(errorMsg, "0")) {
                         printf("serverPublish() API failed, error: %s\n", errorMsg);
                         return -1;
@@ -134,7 +135,7 @@ int main(int argc, char **argv) {
             }
         }
     } else if (!strcmp(contextConfig.direction, "SUB")) {
-        errorMsg = Subscribe(topicConfigs, totalTopics, "START", cb, NULL);
+        errorMsg = Subscribe(context, topicConfigs, totalTopics, "START", cb, NULL);
         if(strcmp(errorMsg, "0")) {
             printf("clientSubscribe() API failed, error: %s\n", errorMsg);
             return -1;
@@ -142,7 +143,7 @@ int main(int argc, char **argv) {
         printf("clientSubscribe() API successfully executed!\n");
         sleep(60 * 2);
     }
-    ContextDestroy();
+    ContextDestroy(context);
     printf("ContextDestroy() for %s API successfully executed!\n", contextConfig.direction);
 
 }
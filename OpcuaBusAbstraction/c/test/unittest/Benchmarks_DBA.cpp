@@ -0,0 +1,296 @@
+/*
+Copyright (c) 2021 Intel Corporation.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <CommonTestUtils.h>
+
+#define MSG_SIZE 100
+#define TOPIC_NAME 32
+
+char pub[] = "PUB";
+char sub[] = "SUB";
+char ns[] = "tm";
+char dtype[] = "string";
+char endpoint[] = "opcua://localhost:65020";
+
+/* Steady state publish cost: all topics are registered before the timed
+ * loop, which publishes to them round robin */
+static void BM_Publish(benchmark::State& state) {
+    int numOfTopics = state.range(0);
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = (char*) "";
+
+    initContext(&contextConfig, (char*) "", (char*) "",
+                trustFileArray, 1, endpoint, pub);
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    if (strcmp(errorMsg, "0")) {
+        freeContext(&contextConfig);
+        state.SkipWithError(errorMsg);
+        return;
+    }
+
+    std::vector<struct TopicConfig> topicConfigs(numOfTopics);
+    for (int i = 0; i < numOfTopics; i++) {
+        char topicName[TOPIC_NAME] = {0x00};
+        sprintf(topicName, "topic%d", i);
+        initTopic(&topicConfigs[i], topicName, ns, dtype);
+        errorMsg = Publish(context, topicConfigs[i], "registration");
+        if (strcmp(errorMsg, "0")) {
+            state.SkipWithError(errorMsg);
+        }
+    }
+
+    char data[MSG_SIZE] = {0x00};
+    snprintf(data, MSG_SIZE, "benchmark data");
+    int next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Publish(context, topicConfigs[next], data));
+        if (++next == numOfTopics) {
+            next = 0;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    ContextDestroy(context);
+    for (int i = 0; i < numOfTopics; i++) {
+        freeTopic(&topicConfigs[i]);
+    }
+    freeContext(&contextConfig);
+}
+BENCHMARK(BM_Publish)->Arg(3)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+/* Same fan-out as BM_Publish, but all topics are published with one
+ * PublishBatch call per iteration */
+static void BM_PublishBatch(benchmark::State& state) {
+    int numOfTopics = state.range(0);
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = (char*) "";
+
+    initContext(&contextConfig, (char*) "", (char*) "",
+                trustFileArray, 1, endpoint, pub);
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    if (strcmp(errorMsg, "0")) {
+        freeContext(&contextConfig);
+        state.SkipWithError(errorMsg);
+        return;
+    }
+
+    char data[MSG_SIZE] = {0x00};
+    snprintf(data, MSG_SIZE, "benchmark data");
+    std::vector<struct TopicConfig> topicConfigs(numOfTopics);
+    std::vector<const char*> datas(numOfTopics, data);
+    std::vector<size_t> lens(numOfTopics, strlen(data));
+    for (int i = 0; i < numOfTopics; i++) {
+        char topicName[TOPIC_NAME] = {0x00};
+        sprintf(topicName, "topic%d", i);
+        initTopic(&topicConfigs[i], topicName, ns, dtype);
+    }
+    errorMsg = PublishBatch(context, topicConfigs.data(), datas.data(), lens.data(), numOfTopics);
+    if (strcmp(errorMsg, "0")) {
+        state.SkipWithError(errorMsg);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PublishBatch(context, topicConfigs.data(), datas.data(),
+                                              lens.data(), numOfTopics));
+    }
+    state.SetItemsProcessed(state.iterations() * numOfTopics);
+
+    ContextDestroy(context);
+    for (int i = 0; i < numOfTopics; i++) {
+        freeTopic(&topicConfigs[i]);
+    }
+    freeContext(&contextConfig);
+}
+BENCHMARK(BM_PublishBatch)->Arg(3)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+/* Publishing one payload of range(0) bytes to 3 topics round robin, the
+ * payload is shared by the topics instead of being copied for each of them */
+static void BM_PublishPayload(benchmark::State& state) {
+    int numOfTopics = 3;
+    size_t length = state.range(0);
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = (char*) "";
+
+    initContext(&contextConfig, (char*) "", (char*) "",
+                trustFileArray, 1, endpoint, pub);
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    if (strcmp(errorMsg, "0")) {
+        freeContext(&contextConfig);
+        state.SkipWithError(errorMsg);
+        return;
+    }
+
+    std::vector<struct TopicConfig> topicConfigs(numOfTopics);
+    for (int i = 0; i < numOfTopics; i++) {
+        char topicName[TOPIC_NAME] = {0x00};
+        sprintf(topicName, "topic%d", i);
+        initTopic(&topicConfigs[i], topicName, ns, dtype);
+        errorMsg = Publish(context, topicConfigs[i], "registration");
+        if (strcmp(errorMsg, "0")) {
+            state.SkipWithError(errorMsg);
+        }
+    }
+
+    struct Payload *payload = payloadNew(length);
+    if (payload == NULL) {
+        state.SkipWithError("payloadNew failed");
+    } else {
+        memset(payloadData(payload), 'x', length);
+        int next = 0;
+        for (auto _ : state) {
+            payloadRetain(payload);
+            benchmark::DoNotOptimize(PublishPayload(context, topicConfigs[next], payload));
+            if (++next == numOfTopics) {
+                next = 0;
+            }
+        }
+        payloadRelease(payload);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * length);
+
+    ContextDestroy(context);
+    for (int i = 0; i < numOfTopics; i++) {
+        freeTopic(&topicConfigs[i]);
+    }
+    freeContext(&contextConfig);
+}
+BENCHMARK(BM_PublishPayload)->Arg(100)->Arg(60 * 1024)->Unit(benchmark::kMicrosecond);
+
+/* Publishers contending for one server: each of the threads publishes to its
+ * own topic, like one Go worker per subscribed topic. The context and the
+ * topics are set up by thread 0 before the timed loop, which the threads
+ * start together */
+static struct DataBusContext *contendedContext = NULL;
+static struct ContextConfig contendedContextConfig;
+static std::vector<struct TopicConfig> contendedTopicConfigs;
+static char *contendedError = NULL;
+
+static void BM_PublishContended(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        char *trustFileArray[2] = {0x00};
+        trustFileArray[0] = (char*) "";
+
+        initContext(&contendedContextConfig, (char*) "", (char*) "",
+                    trustFileArray, 1, endpoint, pub);
+        contendedError = ContextCreate(contendedContextConfig, &contendedContext);
+        contendedTopicConfigs.resize(state.threads());
+        for (int i = 0; i < state.threads(); i++) {
+            char topicName[TOPIC_NAME] = {0x00};
+            sprintf(topicName, "topic%d", i);
+            initTopic(&contendedTopicConfigs[i], topicName, ns, dtype);
+            if (!strcmp(contendedError, "0")) {
+                contendedError = Publish(contendedContext, contendedTopicConfigs[i], "registration");
+            }
+        }
+    }
+
+    char data[MSG_SIZE] = {0x00};
+    snprintf(data, MSG_SIZE, "benchmark data %d", state.thread_index());
+    for (auto _ : state) {
+        if (strcmp(contendedError, "0")) {
+            state.SkipWithError(contendedError);
+            break;
+        }
+        benchmark::DoNotOptimize(Publish(contendedContext,
+                                         contendedTopicConfigs[state.thread_index()], data));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        ContextDestroy(contendedContext);
+        contendedContext = NULL;
+        for (int i = 0; i < state.threads(); i++) {
+            freeTopic(&contendedTopicConfigs[i]);
+        }
+        freeContext(&contendedContextConfig);
+    }
+}
+BENCHMARK(BM_PublishContended)->ThreadRange(1, 32)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void subscribeCb(const char *topic, const char *data, void *userFunc) {
+}
+
+/* Subscribe cost of a client to range(0) topics of a publisher: resolving the
+ * topic nodes and creating their monitored items. Connecting and
+ * disconnecting the client is not timed */
+static void BM_Subscribe(benchmark::State& state) {
+    int numOfTopics = state.range(0);
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = (char*) "";
+
+    initContext(&contextConfig, (char*) "", (char*) "",
+                trustFileArray, 1, endpoint, pub);
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    if (strcmp(errorMsg, "0")) {
+        freeContext(&contextConfig);
+        state.SkipWithError(errorMsg);
+        return;
+    }
+
+    std::vector<struct TopicConfig> topicConfigs(numOfTopics);
+    for (int i = 0; i < numOfTopics; i++) {
+        char topicName[TOPIC_NAME] = {0x00};
+        sprintf(topicName, "topic%d", i);
+        initTopic(&topicConfigs[i], topicName, ns, dtype);
+        errorMsg = Publish(context, topicConfigs[i], "registration");
+        if (strcmp(errorMsg, "0")) {
+            state.SkipWithError(errorMsg);
+        }
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        /* ContextCreate() tokenizes the endpoint of the config */
+        struct ContextConfig subContextConfig;
+        initContext(&subContextConfig, (char*) "", (char*) "",
+                    trustFileArray, 1, endpoint, sub);
+        struct DataBusContext *subContext = NULL;
+        errorMsg = ContextCreate(subContextConfig, &subContext);
+        freeContext(&subContextConfig);
+        if (strcmp(errorMsg, "0")) {
+            state.SkipWithError(errorMsg);
+            break;
+        }
+        state.ResumeTiming();
+        errorMsg = Subscribe(subContext, topicConfigs.data(), numOfTopics, "START",
+                             subscribeCb, NULL);
+        state.PauseTiming();
+        ContextDestroy(subContext);
+        if (strcmp(errorMsg, "0")) {
+            state.SkipWithError(errorMsg);
+            break;
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * numOfTopics);
+
+    ContextDestroy(context);
+    for (int i = 0; i < numOfTopics; i++) {
+        freeTopic(&topicConfigs[i]);
+    }
+    freeContext(&contextConfig);
+}
+/* every iteration connects a client, bound them */
+BENCHMARK(BM_Subscribe)->Arg(10)->Arg(1000)->Iterations(10)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
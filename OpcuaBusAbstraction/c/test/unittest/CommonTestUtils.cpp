@@ -67,6 +67,9 @@ void initContext(struct ContextConfig *contextConfig, char *certFile,
     } else {
         contextConfig->direction = NULL;
     }
+    contextConfig->notifyOnWrite = false;
+    contextConfig->serverWorkers = 0;
+    contextConfig->dispatchWorkers = 0;
 }
 
 void freeContext(struct ContextConfig *contextConfig) {
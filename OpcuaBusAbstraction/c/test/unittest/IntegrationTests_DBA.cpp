@@ -12,6 +12,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <string>
+#include <unistd.h>
 #include <gtest/gtest.h>
 #include <CommonTestUtils.h>
 
@@ -26,6 +28,7 @@ char pubsub[] = "PUBSUB";
 char certFile[] = "/etc/ssl/opcua/opcua_client_certificate.der";
 char privateFile[] = "/etc/ssl/opcua/opcua_client_key.der";
 char trustFile[] = "/etc/ssl/ca/ca_certificate.der";
+char emptyFile[] = "";
 
 char *trustStores[] = {trustFile};
 
@@ -64,6 +67,8 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSub) {
     */
     struct ContextConfig contextConfigPub;
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
 
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
@@ -72,7 +77,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSub) {
 
     initContext(&contextConfigPub, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65004", pub);
-    errorMsg = ContextCreate(contextConfigPub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
     isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
@@ -81,7 +86,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSub) {
 
     initContext(&contextConfigSub, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65004", sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
@@ -101,7 +106,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSub) {
         char result[MSG_SIZE] = {0x00};
         sprintf(result, "topic-creation for:%s, Data:%d",
                 tempTopicConfig[i].name, i);
-        errorMsg = Publish(tempTopicConfig[i], result);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
         isError = strcmp(errorMsg, "0");
         if (isError) {
             printf("Publish() API failed, error: %s\n", errorMsg);
@@ -109,7 +114,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSub) {
         ASSERT_EQ(isError, 0);
     }
 
-    errorMsg = Subscribe(tempTopicConfig, NUM_OF_TOPICS, "START", cb,
+    errorMsg = Subscribe(subContext, tempTopicConfig, NUM_OF_TOPICS, "START", cb,
                          reinterpret_cast<void *>(NULL));
     isError = strcmp(errorMsg, "0");
     if (isError) {
@@ -121,7 +126,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSub) {
         char result[MSG_SIZE] = {0x00};
         sprintf(result, "Data-publishing for:%s, Data:%d",
                 tempTopicConfig[i].name, i);
-        errorMsg = Publish(tempTopicConfig[i], result);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
         isError = strcmp(errorMsg, "0");
         if (isError) {
             printf("Publish() API failed, error: %s\n", errorMsg);
@@ -136,7 +141,8 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSub) {
         ASSERT_GT(topicMsgCount[i], 0);
     }
 
-    ContextDestroy();
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     freeContext(&contextConfigSub);
     for (int i = 0; i < NUM_OF_TOPICS; i++) {
@@ -153,15 +159,17 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSubDevMode) {
     */
     struct ContextConfig contextConfigPub;
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
 
     char *trustFileArray[2] = {0x00};
-    trustFileArray[0] = "";
+    trustFileArray[0] = emptyFile;
     char *errorMsg = NULL;
     int isError = 0;
 
     initContext(&contextConfigPub, "", "",
                 trustFileArray, 1, "opcua://localhost:65011", pub);
-    errorMsg = ContextCreate(contextConfigPub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
     isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
@@ -170,7 +178,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSubDevMode) {
 
     initContext(&contextConfigSub, "", "",
                 trustFileArray, 1, "opcua://localhost:65011", sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
@@ -190,7 +198,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSubDevMode) {
         char result[MSG_SIZE] = {0x00};
         sprintf(result, "topic-creation for:%s, Data:%d",
                  tempTopicConfig[i].name, i);
-        errorMsg = Publish(tempTopicConfig[i], result);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
         isError = strcmp(errorMsg, "0");
         if (isError) {
             printf("Publish() API failed, error: %s\n", errorMsg);
@@ -198,7 +206,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSubDevMode) {
         ASSERT_EQ(isError, 0);
     }
 
-    errorMsg = Subscribe(tempTopicConfig, NUM_OF_TOPICS, "START", cb,
+    errorMsg = Subscribe(subContext, tempTopicConfig, NUM_OF_TOPICS, "START", cb,
                          reinterpret_cast<void *>(NULL));
     isError = strcmp(errorMsg, "0");
     if (isError) {
@@ -210,7 +218,7 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSubDevMode) {
         char result[MSG_SIZE] = {0x00};
         sprintf(result, "Data-publishing for:%s, Data:%d",
                  tempTopicConfig[i].name, i);
-        errorMsg = Publish(tempTopicConfig[i], result);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
         isError = strcmp(errorMsg, "0");
         if (isError) {
             printf("Publish() API failed, error: %s\n", errorMsg);
@@ -225,7 +233,8 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSubDevMode) {
         ASSERT_GT(topicMsgCount[i], 0);
     }
 
-    ContextDestroy();
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     freeContext(&contextConfigSub);
     for (int i = 0; i < NUM_OF_TOPICS; i++) {
@@ -233,11 +242,866 @@ TEST(ContextCreateTestCase, PositiveTestcasePubSubDevMode) {
     }
 }
 
+TEST(ContextCreateTestCase, PositiveTestcasePubSubNotifyOnWriteDevMode) {
+    /*Test description: This is test case for Developer mode
+    with value-backed topic variables (notifyOnWrite).
+    PUB creates the 10 topics and publishes some data.
+    SUB is getting the subscribed data. And test case
+    verifies the message count at subscriber end.
+    */
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
+
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    char *errorMsg = NULL;
+    int isError = 0;
+
+    memset(topicMsgCount, 0, sizeof(topicMsgCount));
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65013", pub);
+    contextConfigPub.notifyOnWrite = true;
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    initContext(&contextConfigSub, "", "",
+                trustFileArray, 1, "opcua://localhost:65013", sub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    struct TopicConfig tempTopicConfig[NUM_OF_TOPICS];
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        char topicName[TOPIC_NAME] = {
+            0x00,
+        };
+        sprintf(topicName, "topic%d", i);
+        initTopic(&tempTopicConfig[i], topicName, ns, dtype);
+    }
+
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        char result[MSG_SIZE] = {0x00};
+        sprintf(result, "topic-creation for:%s, Data:%d",
+                 tempTopicConfig[i].name, i);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("Publish() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    errorMsg = Subscribe(subContext, tempTopicConfig, NUM_OF_TOPICS, "START", cb,
+                         reinterpret_cast<void *>(NULL));
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("Subscribe() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        char result[MSG_SIZE] = {0x00};
+        sprintf(result, "Data-publishing for:%s, Data:%d",
+                 tempTopicConfig[i].name, i);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("Publish() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    sleep(5);
+
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        printf("topic%d got %d messages\n", i, topicMsgCount[i]);
+        ASSERT_GT(topicMsgCount[i], 0);
+    }
+
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
+    freeContext(&contextConfigPub);
+    freeContext(&contextConfigSub);
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        freeTopic(&tempTopicConfig[i]);
+    }
+}
+
+/* Counts the notifications of a subscriber in the int pointed to by counter, read it with
+ * __atomic_load_n while the subscriber runs */
+void countCb(const char *topic, const char *data, void *counter) {
+    if (topic && data) {
+        __atomic_add_fetch(reinterpret_cast<int *>(counter), 1, __ATOMIC_RELAXED);
+    }
+}
+
+TEST(ContextCreateTestCase, PositiveTestcasePubSubServerWorkersDevMode) {
+    /*Test description: This is test case for Developer mode
+    with a pool of 4 servers sharing the port (serverWorkers).
+    PUB creates the 10 topics, 4 SUBs connect, each to one of
+    the servers, and subscribe to all of them. PUB publishes
+    some data and the test case verifies that every SUB got
+    messages.
+    */
+    const int numOfSubs = 4;
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfigSub[numOfSubs];
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext[numOfSubs] = {NULL};
+    int subMsgCount[numOfSubs] = {0x00};
+
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    char *errorMsg = NULL;
+    int isError = 0;
+
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65024", pub);
+    contextConfigPub.serverWorkers = 4;
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    struct TopicConfig tempTopicConfig[NUM_OF_TOPICS];
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        char topicName[TOPIC_NAME] = {
+            0x00,
+        };
+        sprintf(topicName, "topic%d", i);
+        initTopic(&tempTopicConfig[i], topicName, ns, dtype);
+        char result[MSG_SIZE] = {0x00};
+        sprintf(result, "topic-creation for:%s, Data:%d",
+                 tempTopicConfig[i].name, i);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("Publish() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    for (int j = 0; j < numOfSubs; j++) {
+        initContext(&contextConfigSub[j], "", "",
+                    trustFileArray, 1, "opcua://localhost:65024", sub);
+        errorMsg = ContextCreate(contextConfigSub[j], &subContext[j]);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("ContextCreate() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+
+        errorMsg = Subscribe(subContext[j], tempTopicConfig, NUM_OF_TOPICS, "START", countCb,
+                             reinterpret_cast<void *>(&subMsgCount[j]));
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("Subscribe() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        char result[MSG_SIZE] = {0x00};
+        sprintf(result, "Data-publishing for:%s, Data:%d",
+                 tempTopicConfig[i].name, i);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("Publish() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    sleep(5);
+
+    for (int j = 0; j < numOfSubs; j++) {
+        int count = __atomic_load_n(&subMsgCount[j], __ATOMIC_RELAXED);
+        printf("subscriber%d got %d messages\n", j, count);
+        ASSERT_GT(count, 0);
+    }
+
+    for (int j = 0; j < numOfSubs; j++) {
+        ContextDestroy(subContext[j]);
+        freeContext(&contextConfigSub[j]);
+    }
+    ContextDestroy(pubContext);
+    freeContext(&contextConfigPub);
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        freeTopic(&tempTopicConfig[i]);
+    }
+}
+
+TEST(ContextCreateTestCase, PositiveTestcasePubSubPayloadDevMode) {
+    /*Test description: This is test case for Developer mode
+    with payloads published without copying (PublishPayload).
+    PUB creates the 10 topics and publishes a payload to each
+    of them, then the same data again in new payloads.
+    SUB is getting the subscribed data. And test case
+    verifies the message count at subscriber end.
+    */
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
+
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    char *errorMsg = NULL;
+    int isError = 0;
+
+    memset(topicMsgCount, 0, sizeof(topicMsgCount));
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65015", pub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    initContext(&contextConfigSub, "", "",
+                trustFileArray, 1, "opcua://localhost:65015", sub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    struct TopicConfig tempTopicConfig[NUM_OF_TOPICS];
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        char topicName[TOPIC_NAME] = {
+            0x00,
+        };
+        sprintf(topicName, "topic%d", i);
+        initTopic(&tempTopicConfig[i], topicName, ns, dtype);
+    }
+
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        char result[MSG_SIZE] = {0x00};
+        sprintf(result, "topic-creation for:%s, Data:%d",
+                 tempTopicConfig[i].name, i);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("Publish() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    errorMsg = Subscribe(subContext, tempTopicConfig, NUM_OF_TOPICS, "START", cb,
+                         reinterpret_cast<void *>(NULL));
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("Subscribe() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < NUM_OF_TOPICS; i++) {
+            char result[MSG_SIZE] = {0x00};
+            sprintf(result, "Payload-publishing for:%s, Data:%d",
+                     tempTopicConfig[i].name, i);
+            struct Payload *payload = payloadNew(strlen(result));
+            ASSERT_TRUE(payload != NULL);
+            memcpy(payloadData(payload), result, strlen(result));
+            /* keep a reference to check the payload outlives the publish */
+            payloadRetain(payload);
+            errorMsg = PublishPayload(pubContext, tempTopicConfig[i], payload);
+            isError = strcmp(errorMsg, "0");
+            if (isError) {
+                printf("PublishPayload() API failed, error: %s\n", errorMsg);
+            }
+            ASSERT_EQ(isError, 0);
+            ASSERT_EQ(memcmp(payloadData(payload), result, strlen(result)), 0);
+            payloadRelease(payload);
+        }
+        usleep(100 * 1000);
+    }
+
+    sleep(5);
+
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        printf("topic%d got %d messages\n", i, topicMsgCount[i]);
+        ASSERT_GT(topicMsgCount[i], 0);
+    }
+
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
+    freeContext(&contextConfigPub);
+    freeContext(&contextConfigSub);
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        freeTopic(&tempTopicConfig[i]);
+    }
+}
+
+// notifications of payloads filled with a single character, which are
+// corrupted if a payload was freed while the server still referred to it
+struct UniformData {
+    int received;
+    int corrupted;
+};
+
+void uniformCb(const struct SubscribedData *data, void *uniform) {
+    struct UniformData *topicData = reinterpret_cast<struct UniformData *>(uniform);
+    const char *value = reinterpret_cast<const char *>(data->data);
+    if (data->length == 0 || value[0] == 't') {
+        /* the value published at the topic creation */
+        return;
+    }
+    topicData->received++;
+    for (size_t i = 1; i < data->length; i++) {
+        if (value[i] != value[0]) {
+            topicData->corrupted++;
+            return;
+        }
+    }
+}
+
+TEST(ContextCreateTestCase, PositiveTestcasePubSubReplacedPayloadDevMode) {
+    /*Test description: This is test case for Developer mode
+    with payloads of different sizes replacing each other
+    every 2 ms while SUB samples them, each filled with a
+    single character. The test case verifies that none of
+    the values received is corrupted, the server reads
+    and samples outliving the payloads they were taken of.
+    */
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
+    struct UniformData uniform;
+    memset(&uniform, 0, sizeof(uniform));
+
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    char *errorMsg = NULL;
+    int isError = 0;
+
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65029", pub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    struct TopicConfig tempTopicConfig;
+    initTopic(&tempTopicConfig, "topic0", ns, dtype);
+    errorMsg = Publish(pubContext, tempTopicConfig, "topic-creation");
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+
+    initContext(&contextConfigSub, "", "",
+                trustFileArray, 1, "opcua://localhost:65029", sub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    errorMsg = SubscribeData(subContext, &tempTopicConfig, 1, "START", uniformCb,
+                             reinterpret_cast<void *>(&uniform));
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("SubscribeData() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+    sleep(1);
+
+    for (int seq = 0; seq < 500; seq++) {
+        size_t length = 1000 + (seq % 7) * 4000;
+        struct Payload *payload = payloadNew(length);
+        ASSERT_TRUE(payload != NULL);
+        memset(payloadData(payload), 'a' + seq % 26, length);
+        errorMsg = PublishPayload(pubContext, tempTopicConfig, payload);
+        ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+        usleep(2000);
+    }
+
+    sleep(2);
+    printf("got %d messages, %d corrupted\n", uniform.received, uniform.corrupted);
+    ASSERT_GT(uniform.received, 0);
+    ASSERT_EQ(uniform.corrupted, 0);
+
+    ContextDestroy(subContext);
+    freeContext(&contextConfigSub);
+    ContextDestroy(pubContext);
+    freeContext(&contextConfigPub);
+    freeTopic(&tempTopicConfig);
+}
+
+// last notification of a topic subscribed with SubscribeData
+struct ReceivedData {
+    std::string dType;
+    bool isArray;
+    std::string data;
+    size_t count;
+    int64_t sourceTimestamp;
+    int64_t serverTimestamp;
+    uint32_t statusCode;
+};
+
+void dataCb(const struct SubscribedData *data, void *received) {
+    /* the data is only valid during the callback, copy it */
+    struct ReceivedData *topicData = reinterpret_cast<struct ReceivedData *>(received) +
+                                     strToInt(data->topic + 5);
+    topicData->dType = data->dType ? data->dType : "";
+    topicData->isArray = data->isArray;
+    topicData->data.assign(reinterpret_cast<const char *>(data->data), data->length);
+    topicData->count = data->count;
+    topicData->sourceTimestamp = data->sourceTimestamp;
+    topicData->serverTimestamp = data->serverTimestamp;
+    topicData->statusCode = data->statusCode;
+}
+
+TEST(ContextCreateTestCase, PositiveTestcaseSubscribeDataDevMode) {
+    /*Test description: This is test case for Developer mode
+    with subscribed data handed over as views (SubscribeData).
+    PUB publishes a string with ']' in the middle and no NUL,
+    bytes with NULs and a double array. SUB is getting the
+    subscribed data and the test case verifies the data, its
+    length and type, and the timestamps of each topic.
+    */
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
+    struct ReceivedData received[3];
+
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    char *errorMsg = NULL;
+    int isError = 0;
+
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65026", pub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    char bytesType[] = "bytes";
+    char doubleArrayType[] = "double[]";
+    struct TopicConfig tempTopicConfig[3];
+    initTopic(&tempTopicConfig[0], "topic0", ns, dtype);
+    initTopic(&tempTopicConfig[1], "topic1", ns, bytesType);
+    initTopic(&tempTopicConfig[2], "topic2", ns, doubleArrayType);
+
+    const char text[] = "[1, 2] and more";
+    const uint8_t bytes[] = {0x00, 0x01, 0x5d, 0x00};
+    const double doubles[] = {1.5, -2.25, 1e10};
+    errorMsg = Publish(pubContext, tempTopicConfig[0], text);
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    errorMsg = PublishBytes(pubContext, tempTopicConfig[1], bytes, sizeof(bytes));
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    errorMsg = PublishValues(pubContext, tempTopicConfig[2], doubles, 3);
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+
+    initContext(&contextConfigSub, "", "",
+                trustFileArray, 1, "opcua://localhost:65026", sub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    errorMsg = SubscribeData(subContext, tempTopicConfig, 3, "START", dataCb,
+                             reinterpret_cast<void *>(received));
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("SubscribeData() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    sleep(2);
+
+    EXPECT_EQ(received[0].dType, "string");
+    EXPECT_FALSE(received[0].isArray);
+    EXPECT_EQ(received[0].data, std::string(text));
+    EXPECT_EQ(received[1].dType, "bytes");
+    EXPECT_EQ(received[1].data, std::string(reinterpret_cast<const char *>(bytes), sizeof(bytes)));
+    EXPECT_EQ(received[2].dType, "double");
+    EXPECT_TRUE(received[2].isArray);
+    EXPECT_EQ(received[2].count, 3);
+    EXPECT_EQ(received[2].data, std::string(reinterpret_cast<const char *>(doubles), sizeof(doubles)));
+    for (int i = 0; i < 3; i++) {
+        EXPECT_NE(received[i].sourceTimestamp, 0);
+        EXPECT_NE(received[i].serverTimestamp, 0);
+        EXPECT_EQ(received[i].statusCode, 0);
+    }
+
+    ContextDestroy(subContext);
+    freeContext(&contextConfigSub);
+    ContextDestroy(pubContext);
+    freeContext(&contextConfigPub);
+    for (int i = 0; i < 3; i++) {
+        freeTopic(&tempTopicConfig[i]);
+    }
+}
+
+// sequence numbers seen by a slow callback of topics subscribed with dispatch workers
+struct DispatchedData {
+    int received[NUM_OF_TOPICS];
+    long lastSeq[NUM_OF_TOPICS];
+    int outOfOrder;
+};
+
+void slowCb(const struct SubscribedData *data, void *dispatched) {
+    struct DispatchedData *topicData = reinterpret_cast<struct DispatchedData *>(dispatched);
+    int topicId = strToInt(data->topic + 5);
+    char value[MSG_SIZE] = {0x00};
+    long seq = -1;
+    memcpy(value, data->data, data->length < MSG_SIZE ? data->length : MSG_SIZE - 1);
+    if (sscanf(value, "%*s %ld", &seq) != 1) {
+        return;
+    }
+    if (seq < topicData->lastSeq[topicId]) {
+        topicData->outOfOrder++;
+    }
+    topicData->lastSeq[topicId] = seq;
+    topicData->received[topicId]++;
+    /* a slow consumer, which holds back its dispatch worker only */
+    usleep(2000);
+}
+
+TEST(ContextCreateTestCase, PositiveTestcasePubSubDispatchWorkersDevMode) {
+    /*Test description: This is test case for Developer mode
+    with the callbacks called by 2 dispatch workers. PUB keeps
+    publishing increasing sequence numbers to 10 topics, SUB
+    is getting the subscribed data with a slow callback. The
+    test case verifies that each topic got its messages in
+    order, and the dispatch counters of the topics.
+    */
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
+    struct DispatchedData dispatched;
+    memset(&dispatched, 0, sizeof(dispatched));
+
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    char *errorMsg = NULL;
+    int isError = 0;
+
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65027", pub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    struct TopicConfig tempTopicConfig[NUM_OF_TOPICS];
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        char topicName[TOPIC_NAME] = {
+            0x00,
+        };
+        sprintf(topicName, "topic%d", i);
+        initTopic(&tempTopicConfig[i], topicName, ns, dtype);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], "topic-creation 0");
+        ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    }
+
+    initContext(&contextConfigSub, "", "",
+                trustFileArray, 1, "opcua://localhost:65027", sub);
+    contextConfigSub.dispatchWorkers = 2;
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    errorMsg = SubscribeData(subContext, tempTopicConfig, NUM_OF_TOPICS, "START", slowCb,
+                             reinterpret_cast<void *>(&dispatched));
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("SubscribeData() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    for (int seq = 1; seq <= 100; seq++) {
+        for (int i = 0; i < NUM_OF_TOPICS; i++) {
+            char result[MSG_SIZE] = {0x00};
+            sprintf(result, "Data-publishing %d", seq);
+            errorMsg = Publish(pubContext, tempTopicConfig[i], result);
+            ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+        }
+        usleep(10000);
+    }
+
+    sleep(5);
+
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        struct DispatchCounters counters;
+        errorMsg = GetDispatchCounters(subContext, tempTopicConfig[i], &counters);
+        ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+        printf("topic:%d got %d messages, queue max depth %lu, max latency %lu us\n", i,
+               dispatched.received[i], (unsigned long) counters.maxDepth,
+               (unsigned long) (counters.latencyMaxNs / 1000));
+        ASSERT_GT(dispatched.received[i], 0);
+        ASSERT_EQ(counters.dispatched, counters.enqueued);
+        ASSERT_EQ(counters.depth, 0);
+        ASSERT_GE(counters.enqueued, dispatched.received[i]);
+        ASSERT_GT(counters.maxDepth, 0);
+    }
+    ASSERT_EQ(dispatched.outOfOrder, 0);
+
+    ContextDestroy(subContext);
+    freeContext(&contextConfigSub);
+    ContextDestroy(pubContext);
+    freeContext(&contextConfigPub);
+    for (int i = 0; i < NUM_OF_TOPICS; i++) {
+        freeTopic(&tempTopicConfig[i]);
+    }
+}
+
+// sequence numbers seen by a callback stalling on its first notification
+struct StalledData {
+    int received;
+    long lastSeq;
+    int outOfOrder;
+    int stalling;
+};
+
+void stalledCb(const struct SubscribedData *data, void *stalled) {
+    struct StalledData *topicData = reinterpret_cast<struct StalledData *>(stalled);
+    char value[MSG_SIZE] = {0x00};
+    long seq = -1;
+    memcpy(value, data->data, data->length < MSG_SIZE ? data->length : MSG_SIZE - 1);
+    if (sscanf(value, "%*s %ld", &seq) != 1) {
+        return;
+    }
+    if (seq < topicData->lastSeq) {
+        topicData->outOfOrder++;
+    }
+    topicData->lastSeq = seq;
+    if (topicData->received++ == 0) {
+        /* longer than the client timeout and the keepalives of the subscription */
+        __atomic_store_n(&topicData->stalling, 1, __ATOMIC_RELEASE);
+        sleep(4);
+        __atomic_store_n(&topicData->stalling, 0, __ATOMIC_RELEASE);
+    }
+}
+
+TEST(ContextCreateTestCase, PositiveTestcasePubSubStalledDispatchWorkerDevMode) {
+    /*Test description: This is test case for Developer mode
+    with a callback called by a dispatch worker stalling for
+    4 seconds on its first notification, while PUB keeps
+    publishing increasing sequence numbers. The test case
+    verifies that the client thread kept taking notifications
+    beyond the capacity of the dispatch queue, dropping the
+    ones that didn't fit, that the subscription survived and
+    that the callback got the latest value, in order.
+    */
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
+    struct StalledData stalled;
+    memset(&stalled, 0, sizeof(stalled));
+
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    char *errorMsg = NULL;
+    int isError = 0;
+
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65028", pub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    struct TopicConfig tempTopicConfig;
+    initTopic(&tempTopicConfig, "topic0", ns, dtype);
+    errorMsg = Publish(pubContext, tempTopicConfig, "Data-publishing 0");
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+
+    initContext(&contextConfigSub, "", "",
+                trustFileArray, 1, "opcua://localhost:65028", sub);
+    contextConfigSub.dispatchWorkers = 1;
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    errorMsg = SubscribeData(subContext, &tempTopicConfig, 1, "START", stalledCb,
+                             reinterpret_cast<void *>(&stalled));
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("SubscribeData() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    for (int i = 0; i < 100 && !__atomic_load_n(&stalled.stalling, __ATOMIC_ACQUIRE); i++) {
+        usleep(10000);
+    }
+    ASSERT_TRUE(__atomic_load_n(&stalled.stalling, __ATOMIC_ACQUIRE));
+
+    long seq = 1;
+    for (; seq <= 200; seq++) {
+        char result[MSG_SIZE] = {0x00};
+        sprintf(result, "Data-publishing %ld", seq);
+        errorMsg = Publish(pubContext, tempTopicConfig, result);
+        ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+        usleep(10000);
+    }
+
+    struct DispatchCounters counters;
+    errorMsg = GetDispatchCounters(subContext, tempTopicConfig, &counters);
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    printf("while stalled: enqueued %lu, dropped %lu, depth %lu\n", (unsigned long) counters.enqueued,
+           (unsigned long) counters.dropped, (unsigned long) counters.depth);
+    ASSERT_TRUE(__atomic_load_n(&stalled.stalling, __ATOMIC_ACQUIRE));
+    /* the client thread went on beyond the 64 notifications the queue holds */
+    ASSERT_GT(counters.enqueued, 65);
+    ASSERT_GT(counters.dropped, 0);
+
+    while (__atomic_load_n(&stalled.stalling, __ATOMIC_ACQUIRE)) {
+        usleep(10000);
+    }
+    /* the subscription survived the stalled callback */
+    errorMsg = Publish(pubContext, tempTopicConfig, "Data-publishing 1000");
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    sleep(2);
+
+    errorMsg = GetDispatchCounters(subContext, tempTopicConfig, &counters);
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    printf("got %d messages, dropped %lu, max latency %lu us\n", stalled.received,
+           (unsigned long) counters.dropped, (unsigned long) (counters.latencyMaxNs / 1000));
+    ASSERT_EQ(counters.depth, 0);
+    ASSERT_EQ(counters.dispatched + counters.dropped, counters.enqueued);
+    ASSERT_EQ(stalled.lastSeq, 1000);
+    ASSERT_EQ(stalled.outOfOrder, 0);
+
+    ContextDestroy(subContext);
+    freeContext(&contextConfigSub);
+    ContextDestroy(pubContext);
+    freeContext(&contextConfigPub);
+    freeTopic(&tempTopicConfig);
+}
+
+TEST(ContextCreateTestCase, PositiveTestcaseSubManyTopicsDevMode) {
+    /*Test description: This is test case for Developer mode
+    with 1000 topics. PUB creates the topics, SUB subscribes to
+    all of them, resolving them in one batch, and PUB publishes
+    to the last ones. The test case verifies that the SUB got
+    the initial value of every topic.
+    */
+    const int numOfTopics = 1000;
+    const int numOfPublished = 10;
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
+    int subMsgCount = 0;
+
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    char *errorMsg = NULL;
+    int isError = 0;
+
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65025", pub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    struct TopicConfig *tempTopicConfig = new struct TopicConfig[numOfTopics];
+    for (int i = 0; i < numOfTopics; i++) {
+        char topicName[TOPIC_NAME] = {
+            0x00,
+        };
+        sprintf(topicName, "topic%d", i);
+        initTopic(&tempTopicConfig[i], topicName, ns, dtype);
+        char result[MSG_SIZE] = {0x00};
+        sprintf(result, "topic-creation for:%s, Data:%d",
+                 tempTopicConfig[i].name, i);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("Publish() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    initContext(&contextConfigSub, "", "",
+                trustFileArray, 1, "opcua://localhost:65025", sub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    errorMsg = Subscribe(subContext, tempTopicConfig, numOfTopics, "START", countCb,
+                         reinterpret_cast<void *>(&subMsgCount));
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("Subscribe() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    for (int i = numOfTopics - numOfPublished; i < numOfTopics; i++) {
+        char result[MSG_SIZE] = {0x00};
+        sprintf(result, "Data-publishing for:%s, Data:%d",
+                 tempTopicConfig[i].name, i);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("Publish() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    sleep(5);
+
+    int count = __atomic_load_n(&subMsgCount, __ATOMIC_RELAXED);
+    printf("subscriber got %d messages\n", count);
+    ASSERT_GE(count, numOfTopics);
+
+    ContextDestroy(subContext);
+    freeContext(&contextConfigSub);
+    ContextDestroy(pubContext);
+    freeContext(&contextConfigPub);
+    for (int i = 0; i < numOfTopics; i++) {
+        freeTopic(&tempTopicConfig[i]);
+    }
+    delete[] tempTopicConfig;
+}
+
 TEST(ContextCreateTestCase, NegativeTestcaseSubWithoutPub) {
     /*Test description: This is test case which verifies
     the SUB do not get created before PUB.
     */
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *subContext = NULL;
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     char *errorMsg = NULL;
@@ -245,14 +1109,14 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubWithoutPub) {
 
     initContext(&contextConfigSub, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65012", sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_NE(isError, 0);
 
-    ContextDestroy();
+    ContextDestroy(subContext);
     freeContext(&contextConfigSub);
 }
 
@@ -261,20 +1125,22 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubWithoutPub) {
     // This is crashing.
     struct ContextConfig contextConfigPub;
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
     
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     int numOfTopic = 1;
     initContext(&contextConfigPub, certFile, privateFile, 
         trustFileArray,1,"opcua://localhost:65010",pub);
-    char *errorMsg = ContextCreate(contextConfigPub);
+    char *errorMsg = ContextCreate(contextConfigPub, &pubContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
 
     initContext(&contextConfigSub, certFile, privateFile, 
         trustFileArray,1,"opcua://localhost:65010",sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
@@ -288,9 +1154,9 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubWithoutPub) {
     topicMsgCount[topicId] = 0;
     char result[100] = {0x00};
     sprintf(result, "topic-creation for:%s, Data:%d", tempTopicConfig.name, topicId);
-    errorMsg = Publish(tempTopicConfig, result);
+    errorMsg = Publish(pubContext, tempTopicConfig, result);
     
-    errorMsg = Subscribe(&tempTopicConfig, 1, "START", cb, (void*)NULL);
+    errorMsg = Subscribe(subContext, &tempTopicConfig, 1, "START", cb, (void*)NULL);
     if(strcmp(errorMsg, "0")) {
         printf("Subscribe() API failed, error: %s\n", errorMsg);
     }
@@ -301,14 +1167,15 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubWithoutPub) {
     
     char *dataToBePublished = (char*)calloc(numChars, sizeof(char));
     memset(dataToBePublished,'A',numChars-1);
-    Publish(tempTopicConfig, dataToBePublished);
+    Publish(pubContext, tempTopicConfig, dataToBePublished);
     
     sleep(5);
 
     printf("topic:%d got %d messages\n",topicId,topicMsgCount[topicId]);
     ASSERT_GT(topicMsgCount[topicId], 0);
 
-    ContextDestroy();
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     freeContext(&contextConfigSub);
     freeTopic(&tempTopicConfig);
@@ -65,6 +65,8 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubToWrongTopic) {
 
     struct ContextConfig contextConfigPub;
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
 
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
@@ -73,7 +75,7 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubToWrongTopic) {
 
     initContext(&contextConfigPub, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65008", pub);
-    errorMsg = ContextCreate(contextConfigPub);
+    errorMsg = ContextCreate(contextConfigPub, &pubContext);
     isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
@@ -82,7 +84,7 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubToWrongTopic) {
 
     initContext(&contextConfigSub, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65008", sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     isError = strcmp(errorMsg, "0");
 
     if (isError) {
@@ -104,7 +106,7 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubToWrongTopic) {
         char result[MSG_SIZE] = {0x00};
         sprintf(result,
                 "topic-creation for:%s, Data:%d", tempTopicConfig[i].name, i);
-        errorMsg = Publish(tempTopicConfig[i], result);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
         isError = strcmp(errorMsg, "0");
         if (isError) {
             printf("Publish() API failed, error: %s\n", errorMsg);
@@ -124,7 +126,7 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubToWrongTopic) {
         initTopic(&tempTopicConfig[i], topicName, ns, dtype);
     }
 
-    errorMsg = Subscribe(tempTopicConfig, NUM_OF_TOPICS, "START",
+    errorMsg = Subscribe(subContext, tempTopicConfig, NUM_OF_TOPICS, "START",
                          cb, reinterpret_cast<void *>(NULL));
     isError = strcmp(errorMsg, "0");
     if (isError) {
@@ -133,7 +135,8 @@ TEST(ContextCreateTestCase, NegativeTestcaseSubToWrongTopic) {
 
     ASSERT_EQ(isError, 0);
 
-    ContextDestroy();
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     freeContext(&contextConfigSub);
     for (int i = 0; i < NUM_OF_TOPICS; i++) {
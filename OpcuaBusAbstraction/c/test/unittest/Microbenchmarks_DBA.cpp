@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2021 Intel Corporation.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/* Microbenchmarks of the steps of the publish and subscribe paths inside
+ * open62541_wrappers.c, timed in isolation on the calling thread without
+ * server or client threads. Payload sizes go from 100B to 60KB, under
+ * PUBLISH_DATA_SIZE */
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <WrapperInternals.h>
+
+#define TOPIC_NAME 32
+
+char ns[] = "tm";
+char topic[] = "topic";
+
+static void payloadSizes(benchmark::internal::Benchmark *b) {
+    b->Arg(100)->Arg(1024)->Arg(10 * 1024)->Arg(60 * 1024);
+}
+
+/* Adding the node of a topic published for the first time, as a data source
+ * variable with range(0) == 0 or a value-backed variable (notifyOnWrite) with
+ * range(0) == 1. The registry and the address space grow with the iterations */
+static void BM_AddTopicVariable(benchmark::State& state) {
+    struct BenchServer *server = benchServerNew(state.range(0) != 0);
+    if (server == NULL) {
+        state.SkipWithError("benchServerNew failed");
+        return;
+    }
+    long next = 0;
+    for (auto _ : state) {
+        char topicName[TOPIC_NAME] = {0x00};
+        sprintf(topicName, "topic%ld", next++);
+        if (!benchAddTopicVariable(server, ns, topicName)) {
+            state.SkipWithError("addTopicVariable failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    benchServerDelete(server);
+}
+BENCHMARK(BM_AddTopicVariable)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+/* DBA_STRCPY of a string of range(0) bytes into a PUBLISH_DATA_SIZE buffer */
+static void BM_DBA_STRCPY(benchmark::State& state) {
+    static char dest[PUBLISH_DATA_SIZE];
+    std::string src(state.range(0), 'x');
+    for (auto _ : state) {
+        DBA_STRCPY(dest, src.c_str());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DBA_STRCPY)->Apply(payloadSizes);
+
+/* DBA_STRNCPY of range(0) bytes into a PUBLISH_DATA_SIZE buffer */
+static void BM_DBA_STRNCPY(benchmark::State& state) {
+    static char dest[PUBLISH_DATA_SIZE];
+    std::string src(state.range(0), 'x');
+    for (auto _ : state) {
+        DBA_STRNCPY(dest, src.c_str(), src.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DBA_STRNCPY)->Apply(payloadSizes);
+
+/* Building the variant of a published string of range(0) bytes: the copy of
+ * the data into a new topic value, released right away */
+static void BM_NewTopicValue(benchmark::State& state) {
+    std::string data(state.range(0), 'x');
+    for (auto _ : state) {
+        struct Payload *value = benchNewTopicValue(data.data(), data.size());
+        if (value == NULL) {
+            state.SkipWithError("newTopicValue failed");
+            break;
+        }
+        payloadRelease(value);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NewTopicValue)->Apply(payloadSizes);
+
+/* Read of the current value of a topic of range(0) bytes by a sample of a
+ * monitored item, which aliases the value */
+static void BM_ReadPublishedData(benchmark::State& state) {
+    std::string data(state.range(0), 'x');
+    struct Payload *value = benchNewTopicValue(data.data(), data.size());
+    if (value == NULL) {
+        state.SkipWithError("newTopicValue failed");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(benchReadPublishedData(value));
+    }
+    state.SetItemsProcessed(state.iterations());
+    payloadRelease(value);
+}
+BENCHMARK(BM_ReadPublishedData)->Arg(100)->Arg(60 * 1024);
+
+/* Encoding of the DataValue of a string of range(0) bytes, as the server
+ * does for every notification of a monitored item */
+static void BM_EncodeDataValue(benchmark::State& state) {
+    std::string data(state.range(0), 'x');
+    struct Payload *value = benchNewTopicValue(data.data(), data.size());
+    std::vector<UA_Byte> buf(data.size() + 1024);
+    if (value == NULL) {
+        state.SkipWithError("newTopicValue failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (benchEncodeDataValue(value, buf.data(), buf.size()) == 0) {
+            state.SkipWithError("UA_encodeBinary failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    payloadRelease(value);
+}
+BENCHMARK(BM_EncodeDataValue)->Apply(payloadSizes);
+
+static void subscribeCb(const char *topic, const char *data, void *userFunc) {
+    benchmark::DoNotOptimize(data);
+}
+
+static void subscribeDataCb(const struct SubscribedData *data, void *userFunc) {
+    benchmark::DoNotOptimize(data->data);
+}
+
+/* Handling of a notification of a string of range(0) bytes by the client
+ * thread, without dispatch workers: a view of the value for a
+ * c_data_callback with range(1) == 0, or a NUL terminated copy for a
+ * c_callback with range(1) == 1 */
+static void BM_SubscriptionCallback(benchmark::State& state) {
+    std::string data(state.range(0), 'x');
+    struct Payload *value = benchNewTopicValue(data.data(), data.size());
+    struct BenchMonitor *monitor = benchMonitorNew(ns, topic, subscribeCb,
+                                                   state.range(1) == 0 ? subscribeDataCb : NULL);
+    if (value == NULL || monitor == NULL) {
+        state.SkipWithError("benchmark setup failed");
+    } else {
+        for (auto _ : state) {
+            benchSubscriptionCallback(monitor, value);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    benchMonitorDelete(monitor);
+    payloadRelease(value);
+}
+BENCHMARK(BM_SubscriptionCallback)->ArgsProduct({{100, 1024, 10 * 1024, 60 * 1024}, {0, 1}});
+
+BENCHMARK_MAIN();
@@ -10,6 +10,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <time.h>
 #include <sys/time.h>
+#include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
 #include <gtest/gtest.h>
@@ -22,6 +23,7 @@ char pubsub[] = "PUBSUB";
 char certFile[] = "/etc/ssl/opcua/opcua_client_certificate.der";
 char privateFile[] = "/etc/ssl/opcua/opcua_client_key.der";
 char trustFile[] = "/etc/ssl/ca/ca_certificate.der";
+char emptyFile[] = "";
 
 char *trustStores[] = {trustFile};
 
@@ -56,24 +58,25 @@ TEST(ContextCreateTestCase, PositiveTestcaseCreateContextPub) {
     /*Test description: This testcase calls ContextCreate API 
     for publisher and do not expect any error message*/
     struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     initContext(&contextConfig, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65003", pub);
-    char *errorMsg = ContextCreate(contextConfig);
+    char *errorMsg = ContextCreate(contextConfig, &context);
     int errLen = strcmp(errorMsg, "0");
     if (errLen) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_EQ(errLen, 0);
-    ContextDestroy();
+    ContextDestroy(context);
     freeContext(&contextConfig);
 }
 
 TEST(ContextCreateTestCase, PositiveTestcaseContextDestroy) {
     /*Test description:This testcase calls ContextDestroy
     and expects no crash.*/
-    ContextDestroy();
+    ContextDestroy(NULL);
 }
 
 TEST(ContextCreateTestCase, PositiveTestcaseSub) {
@@ -82,25 +85,28 @@ TEST(ContextCreateTestCase, PositiveTestcaseSub) {
     message.*/
     struct ContextConfig contextConfigPub;
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
 
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     initContext(&contextConfigPub, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65006", pub);
-    char *errorMsg = ContextCreate(contextConfigPub);
+    char *errorMsg = ContextCreate(contextConfigPub, &pubContext);
     if (strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
 
     initContext(&contextConfigSub, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65006", sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     int isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_EQ(isError, 0);
-    ContextDestroy();
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     freeContext(&contextConfigSub);
 }
@@ -108,6 +114,7 @@ TEST(ContextCreateTestCase, PositiveTestcaseSub) {
 /*
 TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
     char *trustFileArray[2] = {0x00};
     char *errorMsg = NULL;
 
@@ -119,13 +126,13 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     trustFileArray[0] = trustFile;
     initContext(&contextConfig, NULL, privateFile,
         trustFileArray,1,"opcua://localhost:65005", pub);
-    errorMsg = ContextCreate(contextConfig);
+    errorMsg = ContextCreate(contextConfig, &context);
     int isError = strcmp(errorMsg, "0");
     if(isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_EQ(isError, 0);
-    ContextDestroy();
+    ContextDestroy(context);
     freeContext(&contextConfig);
 
     //Test description: This testcase calls ContextCreate API for 
@@ -138,13 +145,13 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     trustFileArray[0] = trustFile;
     initContext(&contextConfig, certFile, NULL,
                 trustFileArray, 1, "opcua://localhost:65005", pubsub);
-    errorMsg = ContextCreate(contextConfig);
+    errorMsg = ContextCreate(contextConfig, &context);
     int isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_NE(isError, 0);
-    ContextDestroy();
+    ContextDestroy(context);
     freeContext(&contextConfig);
 
     //Test description: This testcase calls ContextCreate API for 
@@ -155,13 +162,13 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     trustFileArray[0] = trustFile;
     initContext(&contextConfig, NULL, privateFile,
         trustFileArray,1,"opcua://localhost:65005", pub);
-    errorMsg = ContextCreate(contextConfig);
+    errorMsg = ContextCreate(contextConfig, &context);
     int isError = strcmp(errorMsg, "0");
     if(isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_EQ(isError, 0);
-    ContextDestroy();
+    ContextDestroy(context);
     freeContext(&contextConfig);
 
     //Test description: This testcase calls ContextCreate API for 
@@ -173,13 +180,13 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     trustFileArray[0] = 0x00;
     initContext(&contextConfig, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65005", pub);
-    errorMsg = ContextCreate(contextConfig);
+    errorMsg = ContextCreate(contextConfig, &context);
     int isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_EQ(isError, 0);
-    ContextDestroy();
+    ContextDestroy(context);
     freeContext(&contextConfig);
     
     //Test description: This testcase calls ContextCreate API for 
@@ -190,13 +197,13 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     trustFileArray[0] = trustFile;
     initContext(&contextConfig, "INTEL", "INTEL",
                 trustFileArray, 0, "opcua://localhost:65005", pub);
-    errorMsg = ContextCreate(contextConfig);
+    errorMsg = ContextCreate(contextConfig, &context);
     int isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_EQ(isError, 0);
-    ContextDestroy();
+    ContextDestroy(context);
     freeContext(&contextConfig);
 
     //Test description: This testcase calls ContextCreate API for 
@@ -207,13 +214,13 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     trustFileArray[0] = trustFile;
     initContext(&contextConfig, NULL, NULL, 
         trustFileArray,0,"opcua://localhost:65005", pub);
-    errorMsg = ContextCreate(contextConfig);
+    errorMsg = ContextCreate(contextConfig, &context);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     
     ASSERT_NE(strcmp(errorMsg, "0"), 0);
-    ContextDestroy();
+    ContextDestroy(context);
     freeContext(&contextConfig);
 }
 */
@@ -225,24 +232,27 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     // TODO:This test case need to be fixed
     struct ContextConfig contextConfigPub;
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
     
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     initContext(&contextConfigPub, certFile, privateFile, 
         trustFileArray,1,"opcua://localhost:65006",pub);
-    char *errorMsg = ContextCreate(contextConfigPub);
+    char *errorMsg = ContextCreate(contextConfigPub, &pubContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
 
     initContext(&contextConfigSub, NULL, privateFile, 
         trustFileArray,1,"opcua://localhost:65006",sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_NE(strcmp(errorMsg, "0"), 0);
-    ContextDestroy();
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     freeContext(&contextConfigSub);
 }*/
@@ -253,12 +263,14 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
 //     in return.*/
 //     struct ContextConfig contextConfigPub;
 //     struct ContextConfig contextConfigSub;
+//     struct DataBusContext *pubContext = NULL;
+//     struct DataBusContext *subContext = NULL;
 
 //     char *trustFileArray[2] = {0x00};
 //     trustFileArray[0] = trustFile;
 //     initContext(&contextConfigPub, certFile, privateFile,
 //                 trustFileArray, 1, "opcua://localhost:65014", pub);
-//     char *errorMsg = ContextCreate(contextConfigPub);
+//     char *errorMsg = ContextCreate(contextConfigPub, &pubContext);
 //     int isError = strcmp(errorMsg, "0");
 //     if (isError) {
 //         printf("ContextCreate() API failed for PUB, error: %s\n", errorMsg);
@@ -267,14 +279,15 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
 
 //     initContext(&contextConfigSub, certFile, NULL,
 //                 trustFileArray, 1, "opcua://localhost:65014", sub);
-//     errorMsg = ContextCreate(contextConfigSub);
+//     errorMsg = ContextCreate(contextConfigSub, &subContext);
 //     isError = strcmp(errorMsg, "0");
 //     if (isError) {
 //         printf("ContextCreate() API failed for SUB, error: %s\n", errorMsg);
 //     }
 //     ASSERT_NE(isError, 0);
 
-//     ContextDestroy();
+//     ContextDestroy(subContext);
+//     ContextDestroy(pubContext);
 //     freeContext(&contextConfigPub);
 //     freeContext(&contextConfigSub);
 // }
@@ -287,24 +300,27 @@ TEST(ContextCreateTestCase, NegativeTestcasePubNullCryptoArgs) {
     // This is crashing with 0 number of trust files.
     struct ContextConfig contextConfigPub;
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
     
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     initContext(&contextConfigPub, certFile, privateFile, 
         trustFileArray,1,"opcua://localhost:65006",pub);
-    char *errorMsg = ContextCreate(contextConfigPub);
+    char *errorMsg = ContextCreate(contextConfigPub, &pubContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
 
     initContext(&contextConfigSub, certFile, privateFile, 
         trustFileArray,0,"opcua://localhost:65006",sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_NE(strcmp(errorMsg, "0"), 0);
-    ContextDestroy();
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     freeContext(&contextConfigSub);
 }*/
@@ -317,17 +333,18 @@ TEST(ContextCreateTestCase, NegativeTestcaseWrongDirection) {
     // The library should not allow directions
     // other than PUB/SUB
     struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     initContext(&contextConfig, certFile, privateFile,
                 trustFileArray, 1, "opcua://localhost:65005", pubsub);
-    char *errorMsg = ContextCreate(contextConfig);
+    char *errorMsg = ContextCreate(contextConfig, &context);
     int isError = strcmp(errorMsg, "0");
     if (isError) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
     ASSERT_EQ(isError, 0);
-    ContextDestroy();
+    ContextDestroy(context);
     freeContext(&contextConfig);
 }
 
@@ -338,12 +355,13 @@ TEST(ContextCreateTestCase, NegativeTestcaseWrongDirection) {
     // TODO:This need to be fixed.
     // This is crashing while publishing the NULL Data
     struct ContextConfig contextConfigPub;
+    struct DataBusContext *pubContext = NULL;
     
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     initContext(&contextConfigPub, certFile, privateFile, 
         trustFileArray,1,"opcua://localhost:65004",pub);
-    char *errorMsg = ContextCreate(contextConfigPub);
+    char *errorMsg = ContextCreate(contextConfigPub, &pubContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
@@ -358,11 +376,11 @@ TEST(ContextCreateTestCase, NegativeTestcaseWrongDirection) {
     for(int i = 0; i< numOfTopic; i++) {
         char result[100] = {0x00};
         sprintf(result, "topic-creation for:%s, Data:%d", tempTopicConfig[i].name, i);
-        errorMsg = Publish(tempTopicConfig[i], NULL);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], NULL);
         ASSERT_EQ(strcmp(errorMsg, "0"), 0);
     }
 
-    ContextDestroy();
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     for(int i = 0; i< numOfTopic; i++) {
         freeTopic(&tempTopicConfig[i]);
@@ -377,19 +395,21 @@ TEST(ContextCreateTestCase, NegativeTestcaseWrongDirection) {
     // This is crashing while Subscribing the NULL callback
     struct ContextConfig contextConfigPub;
     struct ContextConfig contextConfigSub;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *subContext = NULL;
     
     char *trustFileArray[2] = {0x00};
     trustFileArray[0] = trustFile;
     initContext(&contextConfigPub, certFile, privateFile, 
         trustFileArray,1,"opcua://localhost:65004",pub);
-    char *errorMsg = ContextCreate(contextConfigPub);
+    char *errorMsg = ContextCreate(contextConfigPub, &pubContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
 
     initContext(&contextConfigSub, certFile, privateFile, 
     trustFileArray,1,"opcua://localhost:65004",sub);
-    errorMsg = ContextCreate(contextConfigSub);
+    errorMsg = ContextCreate(contextConfigSub, &subContext);
     if(strcmp(errorMsg, "0")) {
         printf("ContextCreate() API failed, error: %s\n", errorMsg);
     }
@@ -404,17 +424,18 @@ TEST(ContextCreateTestCase, NegativeTestcaseWrongDirection) {
     for(int i = 0; i< numOfTopic; i++) {
         char result[100] = {0x00};
         sprintf(result, "topic-creation for:%s, Data:%d", tempTopicConfig[i].name, i);
-        errorMsg = Publish(tempTopicConfig[i], result);
+        errorMsg = Publish(pubContext, tempTopicConfig[i], result);
         ASSERT_EQ(strcmp(errorMsg, "0"), 0);
     }
 
-    errorMsg = Subscribe(tempTopicConfig, 10, "START", NULL, (void*)NULL);
+    errorMsg = Subscribe(subContext, tempTopicConfig, 10, "START", NULL, (void*)NULL);
     if(strcmp(errorMsg, "0")) {
         printf("Subscribe() API failed, error: %s\n", errorMsg);
     }
     ASSERT_NE(strcmp(errorMsg, "0"), 0);
     
-    ContextDestroy();
+    ContextDestroy(subContext);
+    ContextDestroy(pubContext);
     freeContext(&contextConfigPub);
     freeContext(&contextConfigSub);
     for(int i = 0; i< numOfTopic; i++) {
@@ -422,6 +443,466 @@ TEST(ContextCreateTestCase, NegativeTestcaseWrongDirection) {
     }
 }*/
 
+TEST(ContextCreateTestCase, PositiveTestcasePublishBatchDevMode) {
+    /*Test description: This testcase creates the PUB in developer
+    mode and calls PublishBatch API for 10 topics twice, the first
+    call creates the topics. It does not expect any error message*/
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    initContext(&contextConfig, "", "",
+                trustFileArray, 1, "opcua://localhost:65012", pub);
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    int isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    int numOfTopic = 10;
+    struct TopicConfig tempTopicConfig[numOfTopic];
+    char result[numOfTopic][100];
+    const char *data[numOfTopic];
+    size_t lens[numOfTopic];
+    for (int i = 0; i < numOfTopic; i++) {
+        char topicName[10] = {0x00,};
+        sprintf(topicName, "topic%d", i);
+        initTopic(&tempTopicConfig[i], topicName, ns, dtype);
+        sprintf(result[i], "batch data for:%s, Data:%d", tempTopicConfig[i].name, i);
+        data[i] = result[i];
+        lens[i] = strlen(result[i]);
+    }
+
+    for (int j = 0; j < 2; j++) {
+        errorMsg = PublishBatch(context, tempTopicConfig, data, lens, numOfTopic);
+        isError = strcmp(errorMsg, "0");
+        if (isError) {
+            printf("PublishBatch() API failed, error: %s\n", errorMsg);
+        }
+        ASSERT_EQ(isError, 0);
+    }
+
+    ContextDestroy(context);
+    freeContext(&contextConfig);
+    for (int i = 0; i < numOfTopic; i++) {
+        freeTopic(&tempTopicConfig[i]);
+    }
+}
+
+/* Reads the value of the topic in namespace namespaceName from the opcua server
+ * at endpoint into value, returns the status of the read */
+static UA_StatusCode readNamespaceTopicValue(const char *endpoint, const char *namespaceName,
+                                             const char *topic, UA_Variant *value) {
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+    UA_StatusCode ret = UA_Client_connect(client, endpoint);
+    UA_UInt16 nsIndex = 0;
+    UA_String nsName = UA_STRING((char*) namespaceName);
+    if (ret == UA_STATUSCODE_GOOD) {
+        ret = UA_Client_NamespaceGetIndex(client, &nsName, &nsIndex);
+    }
+    if (ret == UA_STATUSCODE_GOOD) {
+        ret = UA_Client_readValueAttribute(client, UA_NODEID_STRING(nsIndex, (char*) topic), value);
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    return ret;
+}
+
+/* Reads the value of the topic in namespace ns */
+static UA_StatusCode readTopicValue(const char *endpoint, char *topic, UA_Variant *value) {
+    return readNamespaceTopicValue(endpoint, ns, topic, value);
+}
+
+TEST(ContextCreateTestCase, PositiveTestcasePublishBytesDevMode) {
+    /*Test description: This testcase creates the PUB in developer
+    mode and calls PublishBytes API with binary data holding NUL
+    bytes. It reads the topic back with an opcua client and expects
+    the same bytes as a ByteString. Publishing a string to that topic
+    and publishing too much data are expected to fail*/
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    initContext(&contextConfig, "", "",
+                trustFileArray, 1, "opcua://localhost:65016", pub);
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    int isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    char blobTopic[] = "blob";
+    struct TopicConfig tempTopicConfig;
+    initTopic(&tempTopicConfig, blobTopic, ns, dtype);
+    const uint8_t blob[] = {0x89, 'P', 'N', 'G', 0x00, 0x0d, 0x0a, 0x00, 0xff};
+    errorMsg = PublishBytes(context, tempTopicConfig, blob, sizeof(blob));
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("PublishBytes() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    errorMsg = Publish(context, tempTopicConfig, "string data");
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+
+    uint8_t *hugeBlob = (uint8_t*) calloc(PUBLISH_DATA_SIZE, 1);
+    ASSERT_TRUE(hugeBlob != NULL);
+    errorMsg = PublishBytes(context, tempTopicConfig, hugeBlob, PUBLISH_DATA_SIZE);
+    free(hugeBlob);
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+
+    usleep(100 * 1000);
+    UA_Variant value;
+    UA_Variant_init(&value);
+    ASSERT_EQ(readTopicValue("opc.tcp://localhost:65016", blobTopic, &value), UA_STATUSCODE_GOOD);
+    ASSERT_TRUE(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_BYTESTRING]));
+    UA_ByteString *bytes = (UA_ByteString*) value.data;
+    ASSERT_EQ(bytes->length, sizeof(blob));
+    ASSERT_EQ(memcmp(bytes->data, blob, sizeof(blob)), 0);
+    UA_Variant_clear(&value);
+
+    ContextDestroy(context);
+    freeContext(&contextConfig);
+    freeTopic(&tempTopicConfig);
+}
+
+TEST(ContextCreateTestCase, PositiveTestcasePublishValuesDevMode) {
+    /*Test description: This testcase creates the PUB in developer
+    mode and calls PublishValues API for a double topic and an
+    int32[] topic. It reads the topics back with an opcua client and
+    expects a Double scalar and an Int32 array. Publishing a string
+    to the double topic, several values to the scalar topic and
+    values to a string topic are expected to fail*/
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    initContext(&contextConfig, "", "",
+                trustFileArray, 1, "opcua://localhost:65017", pub);
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    int isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    char scoreTopic[] = "score";
+    char countsTopic[] = "counts";
+    char doubleType[] = "double";
+    char int32ArrayType[] = "int32[]";
+    struct TopicConfig scoreTopicConfig;
+    struct TopicConfig countsTopicConfig;
+    struct TopicConfig stringTopicConfig;
+    initTopic(&scoreTopicConfig, scoreTopic, ns, doubleType);
+    initTopic(&countsTopicConfig, countsTopic, ns, int32ArrayType);
+    initTopic(&stringTopicConfig, topicName, ns, dtype);
+
+    double score = 0.93;
+    errorMsg = PublishValues(context, scoreTopicConfig, &score, 1);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("PublishValues() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    int32_t counts[] = {3, 0, 7};
+    errorMsg = PublishValues(context, countsTopicConfig, counts, 3);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("PublishValues() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    errorMsg = Publish(context, scoreTopicConfig, "0.93");
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+    double scores[] = {0.93, 0.07};
+    errorMsg = PublishValues(context, scoreTopicConfig, scores, 2);
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+    errorMsg = PublishValues(context, stringTopicConfig, &score, 1);
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+
+    usleep(100 * 1000);
+    UA_Variant value;
+    UA_Variant_init(&value);
+    ASSERT_EQ(readTopicValue("opc.tcp://localhost:65017", scoreTopic, &value), UA_STATUSCODE_GOOD);
+    ASSERT_TRUE(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_DOUBLE]));
+    ASSERT_EQ(*(double*) value.data, score);
+    UA_Variant_clear(&value);
+
+    ASSERT_EQ(readTopicValue("opc.tcp://localhost:65017", countsTopic, &value), UA_STATUSCODE_GOOD);
+    ASSERT_TRUE(UA_Variant_hasArrayType(&value, &UA_TYPES[UA_TYPES_INT32]));
+    ASSERT_EQ(value.arrayLength, 3u);
+    ASSERT_EQ(memcmp(value.data, counts, sizeof(counts)), 0);
+    UA_Variant_clear(&value);
+
+    ContextDestroy(context);
+    freeContext(&contextConfig);
+    freeTopic(&scoreTopicConfig);
+    freeTopic(&countsTopicConfig);
+    freeTopic(&stringTopicConfig);
+}
+
+TEST(ContextCreateTestCase, PositiveTestcaseMultipleContextsDevMode) {
+    /*Test description: This testcase creates two PUBs in developer
+    mode on different ports in the same process and publishes other
+    data to the same topic on each. It reads the topic back from both
+    servers, then destroys the first PUB and expects the second one
+    to keep serving its data*/
+    struct ContextConfig contextConfigPub;
+    struct ContextConfig contextConfig;
+    struct DataBusContext *pubContext = NULL;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    initContext(&contextConfigPub, "", "",
+                trustFileArray, 1, "opcua://localhost:65018", pub);
+    char *errorMsg = ContextCreate(contextConfigPub, &pubContext);
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    initContext(&contextConfig, "", "",
+                trustFileArray, 1, "opcua://localhost:65019", pub);
+    errorMsg = ContextCreate(contextConfig, &context);
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    ASSERT_TRUE(pubContext != context);
+
+    struct TopicConfig tempTopicConfig;
+    initTopic(&tempTopicConfig, topicName, ns, dtype);
+    errorMsg = Publish(pubContext, tempTopicConfig, "first server");
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    errorMsg = Publish(context, tempTopicConfig, "second server");
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+
+    usleep(100 * 1000);
+    UA_Variant value;
+    UA_Variant_init(&value);
+    ASSERT_EQ(readTopicValue("opc.tcp://localhost:65018", topicName, &value), UA_STATUSCODE_GOOD);
+    ASSERT_TRUE(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_STRING]));
+    UA_String *str = (UA_String*) value.data;
+    ASSERT_EQ(str->length, strlen("first server"));
+    ASSERT_EQ(memcmp(str->data, "first server", str->length), 0);
+    UA_Variant_clear(&value);
+
+    ContextDestroy(pubContext);
+    errorMsg = Publish(context, tempTopicConfig, "second server again");
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    usleep(100 * 1000);
+    ASSERT_EQ(readTopicValue("opc.tcp://localhost:65019", topicName, &value), UA_STATUSCODE_GOOD);
+    ASSERT_TRUE(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_STRING]));
+    str = (UA_String*) value.data;
+    ASSERT_EQ(str->length, strlen("second server again"));
+    ASSERT_EQ(memcmp(str->data, "second server again", str->length), 0);
+    UA_Variant_clear(&value);
+
+    ContextDestroy(context);
+    freeContext(&contextConfigPub);
+    freeContext(&contextConfig);
+    freeTopic(&tempTopicConfig);
+}
+
+TEST(ContextCreateTestCase, NegativeTestcasePublishBatchWithoutPub) {
+    /*Test description: This testcase calls PublishBatch API
+    without creating the PUB and expects the error message
+    in return*/
+    struct TopicConfig tempTopicConfig;
+    initTopic(&tempTopicConfig, topicName, ns, dtype);
+    const char *data[1] = {"batch data"};
+    size_t lens[1] = {strlen(data[0])};
+    char *errorMsg = PublishBatch(NULL, &tempTopicConfig, data, lens, 1);
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+    freeTopic(&tempTopicConfig);
+}
+
+TEST(ContextCreateTestCase, PositiveTestcaseMetricsDevMode) {
+    /*Test description: This testcase creates the PUB in developer
+    mode, publishes a string topic 5 times and a bytes topic once
+    and expects the server and topic metrics to count them, with
+    ordered latency quantiles. It then calls PublishMetrics API and
+    reads the publish count of the string topic back from the
+    Diagnostics namespace, whose variables aren't counted as topics.
+    Publishing to the Diagnostics namespace and getting the metrics
+    without a PUB are expected to fail*/
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    initContext(&contextConfig, "", "",
+                trustFileArray, 1, "opcua://localhost:65041", pub);
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    int isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("ContextCreate() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+
+    char blobTopic[] = "metrics_blob";
+    char bytesType[] = "bytes";
+    struct TopicConfig stringTopicConfig;
+    struct TopicConfig blobTopicConfig;
+    initTopic(&stringTopicConfig, topicName, ns, dtype);
+    initTopic(&blobTopicConfig, blobTopic, ns, bytesType);
+    const char data[] = "metrics data";
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(strcmp(Publish(context, stringTopicConfig, data), "0"), 0);
+    }
+    const uint8_t blob[] = {1, 0, 2};
+    ASSERT_EQ(strcmp(PublishBytes(context, blobTopicConfig, blob, sizeof(blob)), "0"), 0);
+
+    char diagnosticsNs[] = DIAGNOSTICS_NAMESPACE;
+    struct TopicConfig diagnosticsTopicConfig;
+    initTopic(&diagnosticsTopicConfig, topicName, diagnosticsNs, dtype);
+    ASSERT_NE(strcmp(Publish(context, diagnosticsTopicConfig, data), "0"), 0);
+    ASSERT_NE(strcmp(PublishBytes(context, diagnosticsTopicConfig, blob, sizeof(blob)), "0"), 0);
+    const char *batchData[] = {data};
+    const size_t batchLens[] = {strlen(data)};
+    ASSERT_NE(strcmp(PublishBatch(context, &diagnosticsTopicConfig, batchData, batchLens, 1), "0"), 0);
+    freeTopic(&diagnosticsTopicConfig);
+    char int64Type[] = "int64";
+    initTopic(&diagnosticsTopicConfig, topicName, diagnosticsNs, int64Type);
+    const int64_t diagnosticsValue = 1;
+    ASSERT_NE(strcmp(PublishValues(context, diagnosticsTopicConfig, &diagnosticsValue, 1), "0"), 0);
+    freeTopic(&diagnosticsTopicConfig);
+
+    struct ServerMetrics serverMetrics;
+    ASSERT_EQ(strcmp(GetServerMetrics(context, &serverMetrics), "0"), 0);
+    ASSERT_EQ(serverMetrics.topicCount, 2u);
+
+    struct TopicMetrics topicMetrics[4];
+    size_t count = 0;
+    ASSERT_EQ(strcmp(GetTopicMetrics(context, topicMetrics, 1, &count), "0"), 0);
+    ASSERT_EQ(count, 2u);
+    ASSERT_EQ(strcmp(GetTopicMetrics(context, topicMetrics, 4, &count), "0"), 0);
+    ASSERT_EQ(count, 2u);
+    struct TopicMetrics *stringMetrics = &topicMetrics[strcmp(topicMetrics[0].topic, topicName) ? 1 : 0];
+    struct TopicMetrics *blobMetrics = &topicMetrics[strcmp(topicMetrics[0].topic, topicName) ? 0 : 1];
+    ASSERT_STREQ(stringMetrics->topic, topicName);
+    ASSERT_STREQ(stringMetrics->ns, ns);
+    ASSERT_EQ(stringMetrics->publishCount, 5u);
+    ASSERT_EQ(stringMetrics->publishBytes, 5 * strlen(data));
+    ASSERT_GT(stringMetrics->latencySumNs, 0u);
+    ASSERT_LE(stringMetrics->latencyP50Ns, stringMetrics->latencyP90Ns);
+    ASSERT_LE(stringMetrics->latencyP90Ns, stringMetrics->latencyP99Ns);
+    ASSERT_LE(stringMetrics->latencyP99Ns, stringMetrics->latencyP999Ns);
+    ASSERT_LE(stringMetrics->latencyP999Ns, stringMetrics->latencyMaxNs);
+    ASSERT_STREQ(blobMetrics->topic, blobTopic);
+    ASSERT_EQ(blobMetrics->publishCount, 1u);
+    ASSERT_EQ(blobMetrics->publishBytes, sizeof(blob));
+
+    errorMsg = PublishMetrics(context);
+    isError = strcmp(errorMsg, "0");
+    if (isError) {
+        printf("PublishMetrics() API failed, error: %s\n", errorMsg);
+    }
+    ASSERT_EQ(isError, 0);
+    ASSERT_EQ(strcmp(GetServerMetrics(context, &serverMetrics), "0"), 0);
+    ASSERT_EQ(serverMetrics.topicCount, 2u);
+
+    usleep(100 * 1000);
+    UA_Variant value;
+    UA_Variant_init(&value);
+    ASSERT_EQ(readNamespaceTopicValue("opc.tcp://localhost:65041", DIAGNOSTICS_NAMESPACE,
+                                      "tm.ab.publishCount", &value), UA_STATUSCODE_GOOD);
+    ASSERT_TRUE(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_INT64]));
+    ASSERT_EQ(*(UA_Int64*) value.data, 5);
+    UA_Variant_clear(&value);
+
+    ContextDestroy(context);
+    freeContext(&contextConfig);
+    freeTopic(&stringTopicConfig);
+    freeTopic(&blobTopicConfig);
+
+    ASSERT_NE(strcmp(GetServerMetrics(NULL, &serverMetrics), "0"), 0);
+    ASSERT_NE(strcmp(GetTopicMetrics(NULL, topicMetrics, 4, &count), "0"), 0);
+    ASSERT_NE(strcmp(PublishMetrics(NULL), "0"), 0);
+}
+
+TEST(ContextCreateTestCase, NegativeTestcaseDispatchWorkersDevMode) {
+    /*Test description: This testcase calls ContextCreate API
+    for a SUB with more dispatch workers than the maximum, and
+    GetDispatchCounters API without a SUB, and expects the error
+    messages in return*/
+    struct ContextConfig contextConfig;
+    struct DataBusContext *context = NULL;
+    char *trustFileArray[2] = {0x00};
+    trustFileArray[0] = emptyFile;
+    initContext(&contextConfig, "", "",
+                trustFileArray, 1, "opcua://localhost:65005", sub);
+    contextConfig.dispatchWorkers = 1000;
+    char *errorMsg = ContextCreate(contextConfig, &context);
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+    ASSERT_EQ(context, (struct DataBusContext *) NULL);
+    freeContext(&contextConfig);
+
+    struct TopicConfig tempTopicConfig;
+    struct DispatchCounters counters;
+    initTopic(&tempTopicConfig, topicName, ns, dtype);
+    errorMsg = GetDispatchCounters(NULL, tempTopicConfig, &counters);
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+    freeTopic(&tempTopicConfig);
+}
+
+/* Pushes a string notification of topic index with length bytes of value */
+static void
+pushNotification(struct NotificationRing *ring, uint32_t index, size_t length, char value) {
+    char data[64];
+    memset(data, value, sizeof(data));
+    struct SubscribedData subscribed;
+    memset(&subscribed, 0, sizeof(subscribed));
+    subscribed.ns = ns;
+    subscribed.topic = topicName;
+    subscribed.dType = "string";
+    subscribed.data = data;
+    subscribed.length = length;
+    subscribed.count = 1;
+    subscribed.topicIndex = index;
+    notificationRingPush(&subscribed, ring);
+}
+
+TEST(ContextCreateTestCase, PositiveTestcaseNotificationRing) {
+    /*Test description: This testcase pushes notifications into
+    a ring of room for two of them, and expects the drains to
+    return them in order, also after the ring wrapped, and to
+    count the notifications dropped while it was full*/
+    size_t recordSize = sizeof(struct NotificationRecord) + 40;
+    struct NotificationRing *ring = notificationRingNew(2 * recordSize + 48);
+    ASSERT_NE(ring, (struct NotificationRing *) NULL);
+    char buf[512];
+    size_t written = 0;
+    uint64_t dropped = 0;
+
+    for (int round = 0; round < 3; round++) {
+        pushNotification(ring, 0, 40, 'a' + round);
+        pushNotification(ring, 1, 40, 'b' + round);
+        pushNotification(ring, 2, 40, 'c' + round);
+        char *errorMsg = notificationRingDrain(ring, buf, sizeof(buf), &written, &dropped);
+        ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+        ASSERT_EQ(written, 2 * recordSize);
+        ASSERT_EQ(dropped, 1);
+        for (uint32_t i = 0; i < 2; i++) {
+            struct NotificationRecord *record = (struct NotificationRecord *) (buf + i * recordSize);
+            ASSERT_EQ(record->size, recordSize);
+            ASSERT_EQ(record->topicIndex, i);
+            ASSERT_EQ(record->length, 40);
+            ASSERT_STREQ(record->dType, "string");
+            ASSERT_EQ(((char *) (record + 1))[39], 'a' + round + i);
+        }
+    }
+
+    /* the records of the ring don't fit into a smaller buffer */
+    pushNotification(ring, 0, 8, 'x');
+    char *errorMsg = notificationRingDrain(ring, buf, 16, &written, &dropped);
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+    errorMsg = notificationRingDrain(ring, buf, sizeof(buf), &written, &dropped);
+    ASSERT_EQ(strcmp(errorMsg, "0"), 0);
+    ASSERT_EQ(written, sizeof(struct NotificationRecord) + 8);
+
+    notificationRingClose(ring);
+    errorMsg = notificationRingDrain(ring, buf, sizeof(buf), &written, &dropped);
+    ASSERT_NE(strcmp(errorMsg, "0"), 0);
+    notificationRingFree(ring);
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
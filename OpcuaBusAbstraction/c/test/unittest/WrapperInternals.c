@@ -0,0 +1,158 @@
+/*
+Copyright (c) 2021 Intel Corporation.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/* Compiles the wrappers with the entry points of WrapperInternals.h into
+ * their static functions. Linked instead of the open62541_wrappers object of
+ * the library, open62541 itself still comes from the library */
+
+#include "open62541_wrappers.c"
+
+/* not part of the public header of open62541 1.2 */
+typedef UA_StatusCode (*UA_exchangeEncodeBuffer)(void *handle, UA_Byte **bufPos,
+                                                 const UA_Byte **bufEnd);
+
+UA_StatusCode
+UA_encodeBinary(const void *src, const UA_DataType *type,
+                UA_Byte **bufPos, const UA_Byte **bufEnd,
+                UA_exchangeEncodeBuffer exchangeCallback,
+                void *exchangeHandle);
+
+struct BenchServer {
+    server_context_t context;
+};
+
+struct BenchMonitor {
+    monitor_context_t args;
+    client_context_t *clientContext;
+};
+
+void
+benchServerDelete(struct BenchServer *server) {
+    if (server != NULL) {
+        cleanupServer(&server->context);
+        free(server);
+    }
+}
+
+struct BenchServer*
+benchServerNew(bool notifyOnWrite) {
+    struct BenchServer *server = (struct BenchServer*) calloc(1, sizeof(struct BenchServer));
+    if (server == NULL) {
+        return NULL;
+    }
+    server_context_t *serverContext = &server->context;
+    serverContext->wakeupFd = -1;
+    serverContext->notifyOnWrite = notifyOnWrite;
+    serverContext->workerCount = 1;
+    serverContext->server = UA_Server_new();
+    serverContext->registryLock = (pthread_rwlock_t*) malloc(sizeof(pthread_rwlock_t));
+    serverContext->buckets = (topic_slot_t**) calloc(TOPIC_REGISTRY_MIN_BUCKETS, sizeof(topic_slot_t*));
+    if (serverContext->buckets != NULL) {
+        serverContext->bucketCount = TOPIC_REGISTRY_MIN_BUCKETS;
+    }
+    if (serverContext->server == NULL || serverContext->registryLock == NULL ||
+        pthread_rwlock_init(serverContext->registryLock, NULL) != 0 || serverContext->buckets == NULL) {
+        free(serverContext->registryLock);
+        serverContext->registryLock = NULL;
+        benchServerDelete(server);
+        return NULL;
+    }
+    serverContext->serverConfig = UA_Server_getConfig(serverContext->server);
+    return server;
+}
+
+bool
+benchAddTopicVariable(struct BenchServer *server,
+                      char *ns,
+                      char *topic) {
+    return addTopicVariable(&server->context, ns, topic, topicHash(ns, topic), &stringTopicType) != NULL;
+}
+
+struct Payload*
+benchNewTopicValue(const char *data,
+                   size_t length) {
+    return newTopicValue(data, length, &stringTopicType);
+}
+
+bool
+benchReadPublishedData(struct Payload *value) {
+    topic_slot_t slot;
+    memset(&slot, 0, sizeof(slot));
+    slot.value = value;
+    UA_DataValue data;
+    UA_DataValue_init(&data);
+    readPublishedData(NULL, NULL, NULL, NULL, &slot, false, NULL, &data);
+    bool hasValue = data.hasValue;
+    UA_DataValue_clear(&data);
+    return hasValue;
+}
+
+struct BenchMonitor*
+benchMonitorNew(char *ns,
+                char *topic,
+                c_callback userCallback,
+                c_data_callback dataCallback) {
+    struct BenchMonitor *monitor = (struct BenchMonitor*) calloc(1, sizeof(struct BenchMonitor));
+    if (monitor == NULL) {
+        return NULL;
+    }
+    monitor->clientContext = (client_context_t*) calloc(1, sizeof(client_context_t));
+    if (monitor->clientContext == NULL) {
+        free(monitor);
+        return NULL;
+    }
+    monitor->args.ns = ns;
+    monitor->args.topic = topic;
+    monitor->args.userCallback = userCallback;
+    monitor->args.dataCallback = dataCallback;
+    monitor->args.clientContext = monitor->clientContext;
+    return monitor;
+}
+
+void
+benchMonitorDelete(struct BenchMonitor *monitor) {
+    if (monitor != NULL) {
+        free(monitor->clientContext);
+        free(monitor);
+    }
+}
+
+/* Notification of value as decoded by the client, aliasing value */
+static void
+benchNotification(struct Payload *value,
+                  UA_DataValue *data) {
+    UA_DataValue_init(data);
+    data->value = value->value;
+    data->hasValue = true;
+    data->sourceTimestamp = UA_DateTime_now();
+    data->hasSourceTimestamp = true;
+    data->serverTimestamp = data->sourceTimestamp;
+    data->hasServerTimestamp = true;
+}
+
+void
+benchSubscriptionCallback(struct BenchMonitor *monitor,
+                          struct Payload *value) {
+    UA_DataValue data;
+    benchNotification(value, &data);
+    subscriptionCallback(NULL, 0, NULL, 0, &monitor->args, &data);
+}
+
+size_t
+benchEncodeDataValue(struct Payload *value,
+                     UA_Byte *buf,
+                     size_t size) {
+    UA_DataValue data;
+    benchNotification(value, &data);
+    UA_Byte *pos = buf;
+    const UA_Byte *end = buf + size;
+    UA_StatusCode ret = UA_encodeBinary(&data, &UA_TYPES[UA_TYPES_DATAVALUE], &pos, &end, NULL, NULL);
+    return ret == UA_STATUSCODE_GOOD ? (size_t)(pos - buf) : 0;
+}
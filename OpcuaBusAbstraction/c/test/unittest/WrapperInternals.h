@@ -0,0 +1,54 @@
+/*
+Copyright (c) 2021 Intel Corporation.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/* Entry points into the internals of open62541_wrappers.c for the
+ * microbenchmarks of the publish and subscribe paths. They are built from a
+ * copy of the wrappers compiled into WrapperInternals.c, not from the library */
+
+#ifndef __WRAPPER_INTERNALS__
+#define __WRAPPER_INTERNALS__
+extern "C"
+{
+#include <DataBus.h>
+
+// server context without server thread, the caller acting as the server thread
+struct BenchServer;
+
+// subscription of a client to one topic, delivering to the callbacks
+struct BenchMonitor;
+
+struct BenchServer* benchServerNew(bool notifyOnWrite);
+
+void benchServerDelete(struct BenchServer *server);
+
+// addTopicVariable of a string topic, false on failure
+bool benchAddTopicVariable(struct BenchServer *server, char *ns, char *topic);
+
+// newTopicValue of a string topic: the copy of a published value into its variant
+struct Payload* benchNewTopicValue(const char *data, size_t length);
+
+// readPublishedData of a topic whose current value is value, false if it read no value
+bool benchReadPublishedData(struct Payload *value);
+
+// monitored item of the topic calling dataCallback or, if NULL, userCallback
+struct BenchMonitor* benchMonitorNew(char *ns, char *topic, c_callback userCallback,
+                                     c_data_callback dataCallback);
+
+void benchMonitorDelete(struct BenchMonitor *monitor);
+
+// subscriptionCallback of a notification of the monitored item carrying value
+void benchSubscriptionCallback(struct BenchMonitor *monitor, struct Payload *value);
+
+// UA_encodeBinary of the DataValue of value with its timestamps into buf, as the server does
+// for a notification. Returns the encoded length, 0 if buf is too small
+size_t benchEncodeDataValue(struct Payload *value, UA_Byte *buf, size_t size);
+}
+
+#endif
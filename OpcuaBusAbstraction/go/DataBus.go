@@ -26,6 +26,7 @@ import (
 	"errors"
 	"strings"
 	"sync"
+	"time"
 
 	"github.com/golang/glog"
 )
@@ -34,7 +35,12 @@ type dataBusContext interface {
 	createContext(map[string]string) error
 	startTopic(map[string]string) error
 	send(map[string]string, interface{}) error
-	receive([]map[string]string, int, string, chan interface{}) error
+	sendBatch([]map[string]string, []interface{}) error
+	newTopic(map[string]string) (topicHandle, error)
+	publishTopics([]*Topic, [][]byte) error
+	receive([]map[string]string, int, string) (<-chan Notification, error)
+	metrics() (*Metrics, error)
+	publishMetrics() error
 	stopTopic(string) error
 	destroyContext() error
 }
@@ -43,10 +49,28 @@ type dataBusContext interface {
 type DataBus interface {
 	ContextCreate(map[string]string) error
 	Publish(map[string]string, interface{}) error
+	PublishBatch([]map[string]string, []interface{}) error
+	Topic(map[string]string) (*Topic, error)
+	PublishTopics([]*Topic, [][]byte) error
 	Subscribe([]map[string]string, int, string, CbType) error
+	SubscribeChannel([]map[string]string, int, string) (<-chan Notification, error)
+	Metrics() (*Metrics, error)
+	PublishMetrics() error
 	ContextDestroy() error
 }
 
+type topicHandle interface {
+	publish([]byte) error
+	publishString(string) error
+	close()
+}
+
+// Topic is the handle of a topic of a publisher, created once with BusCfg.Topic and then
+// published on without converting its topic config for every message
+type Topic struct {
+	handle topicHandle
+}
+
 type topicMeta struct {
 	topicType string
 	data      chan interface{}
@@ -84,7 +108,13 @@ func NewDataBus() (db *BusCfg, err error) {
 	return
 }
 
-// ContextCreate - creates the opcua server/client based on `contextConfig`.direction field
+// ContextCreate - creates the opcua server/client based on `contextConfig`.direction field.
+// A publisher with `contextConfig`["notifyOnWrite"] set to "true" makes its topics value-backed
+// variables, sampled by the subscriptions only after they are published. `contextConfig`["serverWorkers"]
+// set to a number n > 1 makes a publisher a pool of n servers sharing the port, serving the
+// subscriber connections in parallel. The servers don't share their sessions, a reconnecting
+// subscriber landing on another server subscribes again in a new session. `contextConfig`["dispatchWorkers"] set to a number n > 0 makes a
+// subscriber run its callbacks on n threads, keeping the order of each topic
 func (dbus *BusCfg) ContextCreate(contextConfig map[string]string) (err error) {
 	defer errHandler("DataBus Context Creation Failed!!!", &err)
 	dbus.mutex.Lock()
@@ -117,7 +147,9 @@ func (dbus *BusCfg) ContextCreate(contextConfig map[string]string) (err error) {
 	return
 }
 
-// Publish - for publishing the data by opcua server process
+// Publish - for publishing the data by opcua server process. msgData is either a string,
+// a []byte published as a binary ByteString, or for value topics (topicConfig["dType"] boolean, int32,
+// int64, float, double or datetime, suffixed with [] for arrays) a bool, number or time.Time or a slice of them
 func (dbus *BusCfg) Publish(topicConfig map[string]string, msgData interface{}) (err error) {
 	defer errHandler("DataBus Publish Failed!!!", &err)
 	if strings.Contains(dbus.busType, "opcua") {
@@ -129,41 +161,193 @@ func (dbus *BusCfg) Publish(topicConfig map[string]string, msgData interface{})
 	return
 }
 
+// PublishBatch - for publishing msgData[i] on topicConfigs[i] for all the topics
+// with a single call into the opcua server process
+func (dbus *BusCfg) PublishBatch(topicConfigs []map[string]string, msgData []interface{}) (err error) {
+	defer errHandler("DataBus PublishBatch Failed!!!", &err)
+	if len(topicConfigs) != len(msgData) {
+		panic("Topic configs and data count mismatch!!!")
+	}
+	if strings.Contains(dbus.busType, "opcua") {
+		err = dbus.bus.sendBatch(topicConfigs, msgData)
+		if err != nil {
+			panic("sendBatch() Failed!!!")
+		}
+	}
+	return
+}
+
+// Topic - creates the handle of the topic of `topicConfig`, whose dType is string or bytes. Publishing on
+// the handle doesn't allocate Go memory. The handle is valid until ContextDestroy and freed by Topic.Close
+func (dbus *BusCfg) Topic(topicConfig map[string]string) (topic *Topic, err error) {
+	defer errHandler("DataBus Topic Creation Failed!!!", &err)
+	if !strings.Contains(dbus.busType, "opcua") {
+		panic("Unsupported DataBus Type!!!")
+	}
+	handle, err := dbus.bus.newTopic(topicConfig)
+	if err != nil {
+		panic("newTopic() Failed!!!")
+	}
+	topic = &Topic{handle: handle}
+	return
+}
+
+// PublishTopics - for publishing msgData[i] on topics[i] for all the topics with a single call into the
+// opcua server process. The messages are copied into C buffers reused by the next calls
+func (dbus *BusCfg) PublishTopics(topics []*Topic, msgData [][]byte) (err error) {
+	defer errHandler("DataBus PublishTopics Failed!!!", &err)
+	if len(topics) != len(msgData) {
+		panic("Topics and data count mismatch!!!")
+	}
+	if strings.Contains(dbus.busType, "opcua") {
+		err = dbus.bus.publishTopics(topics, msgData)
+		if err != nil {
+			panic("publishTopics() Failed!!!")
+		}
+	}
+	return
+}
+
+// Publish - publishes msgData on the topic, as a String for string topics and a ByteString for bytes topics
+func (topic *Topic) Publish(msgData []byte) error {
+	return topic.handle.publish(msgData)
+}
+
+// PublishString - publishes msgData on the topic like Publish, without converting it to a []byte
+func (topic *Topic) PublishString(msgData string) error {
+	return topic.handle.publishString(msgData)
+}
+
+// Close - frees the topic, which mustn't be published on anymore
+func (topic *Topic) Close() {
+	topic.handle.close()
+}
+
+// ServerMetrics are the server wide metrics of a publisher, summed over its server workers
+type ServerMetrics struct {
+	TopicCount            uint64 // topics published to, the diagnostics ones excepted
+	CurrentChannelCount   uint64 // open secure channels
+	CumulatedChannelCount uint64 // secure channels opened since the server started
+	RejectedChannelCount  uint64
+	CurrentSessionCount   uint64 // open sessions
+	CumulatedSessionCount uint64 // sessions created since the server started
+	RejectedSessionCount  uint64
+	SessionTimeoutCount   uint64
+	SessionAbortCount     uint64
+	RegistryLockWaits     uint64        // topic registry lock acquisitions that had to wait for it
+	RegistryLockWait      time.Duration // total time they waited
+}
+
+// TopicMetrics are the publish metrics of a topic of a publisher. The latency of a publish call is counted
+// for each of its topics, its quantiles are precise to 1/8 of the value
+type TopicMetrics struct {
+	Ns           string
+	Topic        string
+	PublishCount uint64 // values published
+	PublishBytes uint64 // bytes of the values published
+	Drops        uint64 // values replaced by the next one before a server thread took them
+	LatencySum   time.Duration
+	LatencyMax   time.Duration
+	LatencyP50   time.Duration
+	LatencyP90   time.Duration
+	LatencyP99   time.Duration
+	LatencyP999  time.Duration
+}
+
+// Metrics are the metrics a publisher keeps since its context was created
+type Metrics struct {
+	Server ServerMetrics
+	Topics []TopicMetrics
+}
+
+// Metrics - gets the server and topic metrics of a publisher
+func (dbus *BusCfg) Metrics() (metrics *Metrics, err error) {
+	defer errHandler("DataBus Metrics Failed!!!", &err)
+	if dbus.direction != "PUB" {
+		panic("Metrics are kept by a PUB context only!!!")
+	}
+	metrics, err = dbus.bus.metrics()
+	if err != nil {
+		panic("metrics() Failed!!!")
+	}
+	return
+}
+
+// PublishMetrics - mirrors the metrics of a publisher to the int64 variables of the Diagnostics folder of
+// its "Diagnostics" namespace, server.<metric> and <ns>.<topic>.<metric>, for the opcua clients to read
+func (dbus *BusCfg) PublishMetrics() (err error) {
+	defer errHandler("DataBus PublishMetrics Failed!!!", &err)
+	if dbus.direction != "PUB" {
+		panic("Metrics are kept by a PUB context only!!!")
+	}
+	err = dbus.bus.publishMetrics()
+	if err != nil {
+		panic("publishMetrics() Failed!!!")
+	}
+	return
+}
+
 // CbType interface to the user callback function
 type CbType func(topic string, msg interface{})
 
-func worker(topic string, dch chan interface{}, ech chan string, cb CbType) {
-	for {
-		select {
-		case data := <-dch:
-			glog.V(1).Infoln("Worker receiving...")
-			cb(topic, data)
-		case <-ech:
-			glog.V(1).Infoln("Worker terminating...")
-			return
-		}
+// Notification is a value received for a subscribed topic
+type Notification struct {
+	Ns    string
+	Topic string
+	// DType is the data type of the value: string, bytes, boolean, int32, int64, float, double or datetime,
+	// empty if the value is empty or of another opcua data type
+	DType   string
+	IsArray bool
+	// Data is a string, a []byte, or for the other data types a bool, int32, int64, float32, float64 or
+	// time.Time or a slice of them. It is nil if DType is empty
+	Data            interface{}
+	SourceTimestamp time.Time // zero if not sent by the server
+	ServerTimestamp time.Time // zero if not sent by the server
+	StatusCode      uint32    // opcua status code of the value, 0 (Good) if not sent
+}
+
+func worker(ch <-chan Notification, cb CbType) {
+	for n := range ch {
+		glog.V(1).Infoln("Worker receiving...")
+		cb(n.Topic, n.Data)
 	}
+	glog.V(1).Infoln("Worker terminating...")
 }
 
-// Subscribe - makes the subscription to the list of opcua variables (topics) in topicConfig array
+// Subscribe - makes the subscription to the list of opcua variables (topics) in topicConfig array. cb is called
+// with the topic name and the Notification.Data of each notification, in order, from a goroutine of the subscription
 func (dbus *BusCfg) Subscribe(topicConfigs []map[string]string, totalConfigs int, trig string, cb CbType) (err error) {
 	defer errHandler("DataBus Subscription Failed!!!", &err)
-
-	//TODO: Fix the opcua subscriber logic
-	if strings.Contains(dbus.busType, "opcua") {
-		if dbus.direction == "SUB" && trig == "START" && cb != nil {
-			//dch := make(chan interface{})
-			//ech := make(chan string)
-			// go worker(topicConfig["name"], dch, ech, cb)
-			// err = dbus.bus.receive(topicConfigs, totalConfigs, "START", dch)
-			// if err != nil {
-			// 	panic("receive() Failed!!!")
-			// }
-		}
+	if cb == nil {
+		panic("Subscribe callback is nil!!!")
 	}
+	go worker(dbus.subscribe(topicConfigs, totalConfigs, trig), cb)
+	return
+}
+
+// SubscribeChannel - makes the subscription to the list of opcua variables (topics) in topicConfig array,
+// delivering the notifications in order on the returned channel. ContextDestroy closes the channel
+// and drops the notifications not read yet
+func (dbus *BusCfg) SubscribeChannel(topicConfigs []map[string]string, totalConfigs int, trig string) (ch <-chan Notification, err error) {
+	defer errHandler("DataBus Subscription Failed!!!", &err)
+	ch = dbus.subscribe(topicConfigs, totalConfigs, trig)
 	return
 }
 
+func (dbus *BusCfg) subscribe(topicConfigs []map[string]string, totalConfigs int, trig string) <-chan Notification {
+	if !strings.Contains(dbus.busType, "opcua") || dbus.direction != "SUB" {
+		panic("Subscribe needs a SUB context!!!")
+	}
+	if trig != "START" {
+		panic("Unsupported trigger: " + trig)
+	}
+	ch, err := dbus.bus.receive(topicConfigs, totalConfigs, trig)
+	if err != nil {
+		panic("receive() Failed!!!")
+	}
+	return ch
+}
+
 // ContextDestroy function destroys the opcua server/client
 func (dbus *BusCfg) ContextDestroy() (err error) {
 	defer errHandler("DataBus Context Termination Failed!!!", &err)
@@ -25,21 +25,99 @@ package databus
 /*
 #cgo CFLAGS: -I ../c/open62541/include -I ../c
 #cgo LDFLAGS: -L ../c/open62541/src -L ../c -lsafestring -lopen62541W -lmbedtls -lmbedx509 -lmbedcrypto -pthread
-void cgoFunc(char *topic, char *data);
 #include <stdlib.h>
+#include <string.h>
 #include "DataBus.h"
 #include <stdio.h>
+
+// The topic handles pass their context as a void pointer and their C topic config by pointer: cgo
+// boxes the pointers to incomplete structs and the structs holding pointers it checks, which would
+// allocate for every message
+static char*
+publishTopicBytes(void *context, struct TopicConfig *topicConfig, const uint8_t *buf, size_t len) {
+	return PublishBytes(context, *topicConfig, buf, len);
+}
+
+static char*
+publishTopicPayload(void *context, struct TopicConfig *topicConfig, const void *data, size_t len) {
+	if (len >= PUBLISH_DATA_SIZE) {
+		len = PUBLISH_DATA_SIZE - 1;
+	}
+	struct Payload *payload = payloadNew(len);
+	if (payload == NULL) {
+		return "Payload allocation has failed";
+	}
+	if (len > 0) {
+		memcpy(payloadData(payload), data, len);
+	}
+	return PublishPayload(context, *topicConfig, payload);
+}
+
+static char*
+publishTopicsBatch(void *context, struct TopicConfig *topicConfigs, const char **data, const size_t *lens,
+                   size_t count) {
+	return PublishBatch(context, topicConfigs, data, lens, count);
+}
 */
 import "C"
 
 import (
+	"reflect"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
 	"unsafe"
 
 	"github.com/golang/glog"
 )
 
 type dataBusOpcua struct {
-	direction string
+	direction     string
+	context       *C.struct_DataBusContext // handle of the opcua server or client of this instance
+	subscriptions []*subscription
+	// C buffers of the publishTopics calls, reused by the next calls. A call takes a free batch or a new one,
+	// so that concurrent calls don't wait for each other
+	batchesMutex sync.Mutex
+	batches      []*topicsBatch
+	// held for reading by the calls into the context, for writing while it is destroyed
+	contextMutex sync.RWMutex
+}
+
+// topicsBatch holds the C arrays PublishBatch takes, grown as needed and kept for the next batch
+type topicsBatch struct {
+	topicCfgs unsafe.Pointer // array of C.struct_TopicConfig
+	data      unsafe.Pointer // array of pointers into buf
+	lens      unsafe.Pointer // array of C.size_t
+	count     int            // capacity of topicCfgs, data and lens
+	buf       unsafe.Pointer // data of the messages
+	size      int            // capacity of buf
+}
+
+// opcuaTopic is the handle of a topic of a publisher, holding its topic config and its strings in C memory
+type opcuaTopic struct {
+	dbOpcua *dataBusOpcua
+	cfg     *C.struct_TopicConfig
+	isBytes bool // the messages are published as ByteStrings, else as Strings
+}
+
+// MaxPublishSize is the size in bytes a value published on an opcua topic must stay below, larger
+// ByteStrings being rejected and larger Strings truncated
+const MaxPublishSize = C.PUBLISH_DATA_SIZE
+
+// notificationRingSize is the capacity in bytes of the ring the notifications of a subscription are copied into
+// by the C callbacks, and of the buffer the ring is drained into
+const notificationRingSize = 1 << 20
+
+// subscription hands the notifications of a receive call over from the C callbacks to its channel. The
+// callbacks copy them into the ring, which a goroutine drains in batches with a single cgo call each
+type subscription struct {
+	ring   *C.struct_NotificationRing
+	topics []map[string]string
+	cStrs  []*C.char // strings of the topic configs, referenced by the C subscription until it is destroyed
+	ch     chan Notification
+	quit   chan struct{} // closed when the context is destroyed, the channel may not be read anymore
+	done   chan struct{} // closed once the goroutine stopped draining the ring
 }
 
 func newOpcuaInstance() (db *dataBusOpcua, err error) {
@@ -48,15 +126,6 @@ func newOpcuaInstance() (db *dataBusOpcua, err error) {
 	return
 }
 
-var gCh chan interface{}
-
-//export goCallback
-func goCallback(topic *C.char, data *C.char) {
-	dataGoStr := C.GoString(data)
-	gCh <- dataGoStr
-}
-
-//TODO: Debug the crash seen when this is called
 //frees up all CString() allocated memory
 func free(cStrs []*C.char) {
 	for _, str := range cStrs {
@@ -83,6 +152,22 @@ func (dbOpcua *dataBusOpcua) createContext(contextConfig map[string]string) (err
 		a[idx] = C.CString(substring)
 	}
 
+	serverWorkers := 0
+	if contextConfig["serverWorkers"] != "" {
+		serverWorkers, err = strconv.Atoi(contextConfig["serverWorkers"])
+		if err != nil || serverWorkers < 0 {
+			panic("Invalid serverWorkers: " + contextConfig["serverWorkers"])
+		}
+	}
+
+	dispatchWorkers := 0
+	if contextConfig["dispatchWorkers"] != "" {
+		dispatchWorkers, err = strconv.Atoi(contextConfig["dispatchWorkers"])
+		if err != nil || dispatchWorkers < 0 {
+			panic("Invalid dispatchWorkers: " + contextConfig["dispatchWorkers"])
+		}
+	}
+
 	contCfg := C.struct_ContextConfig{
 		endpoint:        cEndpoint,
 		direction:       cDirection,
@@ -90,9 +175,12 @@ func (dbOpcua *dataBusOpcua) createContext(contextConfig map[string]string) (err
 		privateFile:     cPrivateFile,
 		trustFile:       (**C.char)(cArray),
 		trustedListSize: cTrustFilesCount,
+		notifyOnWrite:   C.bool(contextConfig["notifyOnWrite"] == "true"),
+		serverWorkers:   C.size_t(serverWorkers),
+		dispatchWorkers: C.size_t(dispatchWorkers),
 	}
 
-	cResp := C.ContextCreate(contCfg)
+	cResp := C.ContextCreate(contCfg, &dbOpcua.context)
 	goResp := C.GoString(cResp)
 	if goResp != "0" {
 		glog.Errorln("Response: ", goResp)
@@ -101,6 +189,15 @@ func (dbOpcua *dataBusOpcua) createContext(contextConfig map[string]string) (err
 	return
 }
 
+// lockContext read locks the context for a call into it, panicking if it is destroyed
+func (dbOpcua *dataBusOpcua) lockContext() {
+	dbOpcua.contextMutex.RLock()
+	if dbOpcua.context == nil {
+		dbOpcua.contextMutex.RUnlock()
+		panic("Context is destroyed")
+	}
+}
+
 func (dbOpcua *dataBusOpcua) startTopic(topicConfig map[string]string) (err error) {
 	defer errHandler("OPCUA Topic Start Failed!!!", &err)
 	return
@@ -109,17 +206,184 @@ func (dbOpcua *dataBusOpcua) startTopic(topicConfig map[string]string) (err erro
 func (dbOpcua *dataBusOpcua) send(topic map[string]string, msgData interface{}) (err error) {
 	defer errHandler("OPCUA Send Failed!!!", &err)
 	if dbOpcua.direction == "PUB" {
+		dbOpcua.lockContext()
+		defer dbOpcua.contextMutex.RUnlock()
 		cNamespace := C.CString(topic["ns"])
 		cTopic := C.CString(topic["name"])
 		cType := C.CString(topic["dType"])
-		cMsgData := C.CString(msgData.(string))
+		defer C.free(unsafe.Pointer(cNamespace))
+		defer C.free(unsafe.Pointer(cTopic))
+		defer C.free(unsafe.Pointer(cType))
 		topicCfg := C.struct_TopicConfig{
 			ns:    cNamespace,
 			name:  cTopic,
 			dType: cType,
 		}
 
-		cResp := C.Publish(topicCfg, cMsgData)
+		var cResp *C.char
+		switch msg := msgData.(type) {
+		case []byte:
+			// binary data is published as a ByteString, the C side copies it
+			var buf *C.uint8_t
+			if len(msg) > 0 {
+				buf = (*C.uint8_t)(unsafe.Pointer(&msg[0]))
+			}
+			cResp = C.PublishBytes(dbOpcua.context, topicCfg, buf, C.size_t(len(msg)))
+		case string:
+			// the message is copied once, straight into the payload the server shares
+			str := msg
+			if len(str) >= C.PUBLISH_DATA_SIZE {
+				str = str[:C.PUBLISH_DATA_SIZE-1]
+			}
+			payload := C.payloadNew(C.size_t(len(str)))
+			if payload == nil {
+				panic("Payload allocation has failed")
+			}
+			if len(str) > 0 {
+				copy((*[1 << 30]byte)(unsafe.Pointer(C.payloadData(payload)))[:len(str):len(str)], str)
+			}
+			cResp = C.PublishPayload(dbOpcua.context, topicCfg, payload)
+		default:
+			// numbers, booleans and times, or slices of them, as values of the topic dType
+			values, count := encodeValues(topic["dType"], msgData)
+			defer C.free(values)
+			cResp = C.PublishValues(dbOpcua.context, topicCfg, values, C.size_t(count))
+		}
+		goResp := C.GoString(cResp)
+		if goResp != "0" {
+			glog.Errorln("Response: ", goResp)
+			panic(goResp)
+		}
+	}
+	return
+}
+
+// uaDateTimeUnixEpoch is the unix epoch as an UA_DateTime, in 100 ns intervals since 1601-01-01
+const uaDateTimeUnixEpoch = 116444736000000000
+
+// encodeValues converts msg, a scalar or a slice of booleans, numbers or time.Time values, into a
+// C array of the element type of dType as serverPublishValues takes it. The array is malloc'd
+// and has to be freed by the caller
+func encodeValues(dType string, msg interface{}) (unsafe.Pointer, int) {
+	v := reflect.ValueOf(msg)
+	count := 1
+	isSlice := v.Kind() == reflect.Slice || v.Kind() == reflect.Array
+	if isSlice {
+		count = v.Len()
+	}
+
+	var elemSize uintptr
+	baseType := strings.ToLower(strings.TrimSuffix(dType, "[]"))
+	switch baseType {
+	case "boolean":
+		elemSize = unsafe.Sizeof(C.bool(false))
+	case "int32", "int", "float":
+		elemSize = 4
+	case "int64", "double", "datetime":
+		elemSize = 8
+	default:
+		panic("Wrong Data Type!!!")
+	}
+
+	values := C.malloc(C.size_t(uintptr(count)*elemSize + 1))
+	if values == nil {
+		panic("Values allocation has failed")
+	}
+	for i := 0; i < count; i++ {
+		elem := v
+		if isSlice {
+			elem = v.Index(i)
+		}
+		if elem.Kind() == reflect.Interface {
+			elem = elem.Elem()
+		}
+		ptr := unsafe.Pointer(uintptr(values) + uintptr(i)*elemSize)
+		switch baseType {
+		case "boolean":
+			if elem.Kind() != reflect.Bool {
+				C.free(values)
+				panic("Wrong Data Type!!!")
+			}
+			*(*C.bool)(ptr) = C.bool(elem.Bool())
+		case "int32", "int":
+			*(*C.int32_t)(ptr) = C.int32_t(toInt64(elem, values))
+		case "int64":
+			*(*C.int64_t)(ptr) = C.int64_t(toInt64(elem, values))
+		case "float":
+			*(*C.float)(ptr) = C.float(toFloat64(elem, values))
+		case "double":
+			*(*C.double)(ptr) = C.double(toFloat64(elem, values))
+		case "datetime":
+			t, ok := elem.Interface().(time.Time)
+			if !ok {
+				C.free(values)
+				panic("Wrong Data Type!!!")
+			}
+			*(*C.int64_t)(ptr) = C.int64_t(t.UnixNano()/100 + uaDateTimeUnixEpoch)
+		}
+	}
+	return values, count
+}
+
+// toInt64 returns the integer value of elem, freeing values before panicking if it isn't one
+func toInt64(elem reflect.Value, values unsafe.Pointer) int64 {
+	switch elem.Kind() {
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64:
+		return elem.Int()
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32, reflect.Uint64:
+		return int64(elem.Uint())
+	}
+	C.free(values)
+	panic("Wrong Data Type!!!")
+}
+
+// toFloat64 returns the numeric value of elem, freeing values before panicking if it isn't one
+func toFloat64(elem reflect.Value, values unsafe.Pointer) float64 {
+	switch elem.Kind() {
+	case reflect.Float32, reflect.Float64:
+		return elem.Float()
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64:
+		return float64(elem.Int())
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32, reflect.Uint64:
+		return float64(elem.Uint())
+	}
+	C.free(values)
+	panic("Wrong Data Type!!!")
+}
+
+func (dbOpcua *dataBusOpcua) sendBatch(topics []map[string]string, msgData []interface{}) (err error) {
+	defer errHandler("OPCUA SendBatch Failed!!!", &err)
+	if dbOpcua.direction == "PUB" && len(topics) > 0 {
+		dbOpcua.lockContext()
+		defer dbOpcua.contextMutex.RUnlock()
+		count := len(topics)
+		cTopicCfgs := C.malloc(C.size_t(count) * C.size_t(unsafe.Sizeof(C.struct_TopicConfig{})))
+		cData := C.malloc(C.size_t(count) * C.size_t(unsafe.Sizeof(uintptr(0))))
+		cLens := C.malloc(C.size_t(count) * C.size_t(unsafe.Sizeof(C.size_t(0))))
+		defer C.free(cTopicCfgs)
+		defer C.free(cData)
+		defer C.free(cLens)
+		topicCfgs := (*[1<<30 - 1]C.struct_TopicConfig)(cTopicCfgs)[:count:count]
+		data := (*[1<<30 - 1]*C.char)(cData)[:count:count]
+		lens := (*[1<<30 - 1]C.size_t)(cLens)[:count:count]
+
+		// the C side copies everything it keeps, so the strings are freed on return
+		cStrs := make([]*C.char, 0, 4*count)
+		defer free(cStrs)
+		for idx, topic := range topics {
+			msg := msgData[idx].(string)
+			topicCfgs[idx] = C.struct_TopicConfig{
+				ns:    C.CString(topic["ns"]),
+				name:  C.CString(topic["name"]),
+				dType: C.CString(topic["dType"]),
+			}
+			data[idx] = C.CString(msg)
+			lens[idx] = C.size_t(len(msg))
+			cStrs = append(cStrs, topicCfgs[idx].ns, topicCfgs[idx].name, topicCfgs[idx].dType, data[idx])
+		}
+
+		cResp := C.PublishBatch(dbOpcua.context, (*C.struct_TopicConfig)(cTopicCfgs), (**C.char)(cData),
+			(*C.size_t)(cLens), C.size_t(count))
 		goResp := C.GoString(cResp)
 		if goResp != "0" {
 			glog.Errorln("Response: ", goResp)
@@ -129,31 +393,424 @@ func (dbOpcua *dataBusOpcua) send(topic map[string]string, msgData interface{})
 	return
 }
 
-func (dbOpcua *dataBusOpcua) receive(topicConfigs []map[string]string, totalConfigs int, trig string, ch chan interface{}) (err error) {
+// succeeded returns whether cResp is the "0" returned by the C functions on success, without converting it
+func succeeded(cResp *C.char) bool {
+	resp := (*[2]byte)(unsafe.Pointer(cResp))
+	return resp[0] == '0' && resp[1] == 0
+}
+
+func (dbOpcua *dataBusOpcua) newTopic(topicConfig map[string]string) (topic topicHandle, err error) {
+	defer errHandler("OPCUA Topic Creation Failed!!!", &err)
+	if dbOpcua.direction != "PUB" {
+		panic("Topics are published by a PUB context only")
+	}
+	dType := strings.ToLower(topicConfig["dType"])
+	if dType != "string" && dType != "bytes" {
+		panic("Unsupported topic dType: " + topicConfig["dType"])
+	}
+	cfg := (*C.struct_TopicConfig)(C.malloc(C.size_t(unsafe.Sizeof(C.struct_TopicConfig{}))))
+	if cfg == nil {
+		panic("Topic allocation has failed")
+	}
+	*cfg = C.struct_TopicConfig{
+		ns:    C.CString(topicConfig["ns"]),
+		name:  C.CString(topicConfig["name"]),
+		dType: C.CString(topicConfig["dType"]),
+	}
+	topic = &opcuaTopic{dbOpcua: dbOpcua, cfg: cfg, isBytes: dType == "bytes"}
+	return
+}
+
+func (topic *opcuaTopic) publish(data []byte) (err error) {
+	defer errHandler("OPCUA Topic Publish Failed!!!", &err)
+	var buf unsafe.Pointer
+	if len(data) > 0 {
+		buf = unsafe.Pointer(&data[0])
+	}
+	topic.publishData(buf, len(data))
+	return
+}
+
+func (topic *opcuaTopic) publishString(data string) (err error) {
+	defer errHandler("OPCUA Topic Publish Failed!!!", &err)
+	var buf unsafe.Pointer
+	if len(data) > 0 {
+		buf = unsafe.Pointer((*reflect.StringHeader)(unsafe.Pointer(&data)).Data)
+	}
+	topic.publishData(buf, len(data))
+	return
+}
+
+// publishData publishes the length bytes at data, which the C side copies: a bytes topic copies them
+// into a ByteString, a string topic once into the payload the server shares
+func (topic *opcuaTopic) publishData(data unsafe.Pointer, length int) {
+	topic.dbOpcua.lockContext()
+	defer topic.dbOpcua.contextMutex.RUnlock()
+	var cResp *C.char
+	if topic.isBytes {
+		cResp = C.publishTopicBytes(unsafe.Pointer(topic.dbOpcua.context), topic.cfg, (*C.uint8_t)(data), C.size_t(length))
+	} else {
+		cResp = C.publishTopicPayload(unsafe.Pointer(topic.dbOpcua.context), topic.cfg, data, C.size_t(length))
+	}
+	if !succeeded(cResp) {
+		goResp := C.GoString(cResp)
+		glog.Errorln("Response: ", goResp)
+		panic(goResp)
+	}
+}
+
+func (topic *opcuaTopic) close() {
+	free([]*C.char{topic.cfg.ns, topic.cfg.name, topic.cfg.dType})
+	C.free(unsafe.Pointer(topic.cfg))
+	topic.cfg = nil
+}
+
+func (dbOpcua *dataBusOpcua) publishTopics(topics []*Topic, data [][]byte) (err error) {
+	defer errHandler("OPCUA PublishTopics Failed!!!", &err)
+	if len(topics) == 0 {
+		return
+	}
+	dbOpcua.lockContext()
+	defer dbOpcua.contextMutex.RUnlock()
+	batch := dbOpcua.takeBatch()
+	defer dbOpcua.putBatch(batch)
+
+	size := 0
+	for _, msg := range data {
+		size += len(msg)
+	}
+	batch.reserve(len(topics), size)
+	topicCfgs := (*[1<<30 - 1]C.struct_TopicConfig)(batch.topicCfgs)[:len(topics):len(topics)]
+	ptrs := (*[1<<30 - 1]*C.char)(batch.data)[:len(topics):len(topics)]
+	lens := (*[1<<30 - 1]C.size_t)(batch.lens)[:len(topics):len(topics)]
+	offset := 0
+	for idx, topic := range topics {
+		topicCfgs[idx] = *topic.handle.(*opcuaTopic).cfg
+		// the messages are copied into the buffer of the batch, the C side copies them again
+		ptrs[idx] = (*C.char)(unsafe.Pointer(uintptr(batch.buf) + uintptr(offset)))
+		lens[idx] = C.size_t(len(data[idx]))
+		if len(data[idx]) > 0 {
+			// passed as a plain pointer, cgo would box the slice of &data[idx][0] to check it
+			msg := unsafe.Pointer(&data[idx][0])
+			C.memcpy(unsafe.Pointer(ptrs[idx]), msg, C.size_t(len(data[idx])))
+		}
+		offset += len(data[idx])
+	}
+
+	cResp := C.publishTopicsBatch(unsafe.Pointer(dbOpcua.context), (*C.struct_TopicConfig)(batch.topicCfgs),
+		(**C.char)(batch.data), (*C.size_t)(batch.lens), C.size_t(len(topics)))
+	if !succeeded(cResp) {
+		goResp := C.GoString(cResp)
+		glog.Errorln("Response: ", goResp)
+		panic(goResp)
+	}
+	return
+}
+
+// takeBatch takes a free batch, or a new one if there is none
+func (dbOpcua *dataBusOpcua) takeBatch() (batch *topicsBatch) {
+	dbOpcua.batchesMutex.Lock()
+	if n := len(dbOpcua.batches); n > 0 {
+		batch = dbOpcua.batches[n-1]
+		dbOpcua.batches = dbOpcua.batches[:n-1]
+	} else {
+		batch = &topicsBatch{}
+	}
+	dbOpcua.batchesMutex.Unlock()
+	return
+}
+
+// putBatch gives the batch back for the next calls
+func (dbOpcua *dataBusOpcua) putBatch(batch *topicsBatch) {
+	dbOpcua.batchesMutex.Lock()
+	dbOpcua.batches = append(dbOpcua.batches, batch)
+	dbOpcua.batchesMutex.Unlock()
+}
+
+// reserve grows the C buffers of the batch to count topics and size bytes of data
+func (batch *topicsBatch) reserve(count int, size int) {
+	if count > batch.count {
+		C.free(batch.topicCfgs)
+		C.free(batch.data)
+		C.free(batch.lens)
+		batch.topicCfgs = C.malloc(C.size_t(count) * C.size_t(unsafe.Sizeof(C.struct_TopicConfig{})))
+		batch.data = C.malloc(C.size_t(count) * C.size_t(unsafe.Sizeof(uintptr(0))))
+		batch.lens = C.malloc(C.size_t(count) * C.size_t(unsafe.Sizeof(C.size_t(0))))
+		batch.count = count
+		if batch.topicCfgs == nil || batch.data == nil || batch.lens == nil {
+			batch.release()
+			panic("Batch allocation has failed")
+		}
+	}
+	if size > batch.size || batch.buf == nil {
+		C.free(batch.buf)
+		// one byte more so that a batch of empty messages still gets a buffer
+		batch.buf = C.malloc(C.size_t(size + 1))
+		batch.size = size
+		if batch.buf == nil {
+			batch.release()
+			panic("Batch allocation has failed")
+		}
+	}
+}
+
+// release frees the C buffers of the batch
+func (batch *topicsBatch) release() {
+	C.free(batch.topicCfgs)
+	C.free(batch.data)
+	C.free(batch.lens)
+	C.free(batch.buf)
+	batch.topicCfgs, batch.data, batch.lens, batch.buf = nil, nil, nil, nil
+	batch.count, batch.size = 0, 0
+}
+
+func (dbOpcua *dataBusOpcua) receive(topicConfigs []map[string]string, totalConfigs int, trig string) (ch <-chan Notification, err error) {
 	defer errHandler("OPCUA Receive Failed!!!", &err)
-	gCh = ch
-	//TODO: opcua subscriber isn't working
-	// cTrig := C.CString(trig)
-	// cTotalConfigs := C.int(totalConfigs)
-	// topicCfg := C.struct_TopicConfig{}
-	// cArray := C.malloc(C.size_t(totalConfigs) * C.size_t(unsafe.Sizeof(C.struct_TopicConfig)))
-	// a := (*[1<<30 - 1]C.struct_TopicConfig)(cArray)
-	// for idx, topicCfg := range topicConfigs {
-	// 	cTopic := C.CString(topicCfg["name"])
-	// 	cType := C.CString(topicCfg["dType"])
-	// 	a[idx] = C.struct_TopicConfig{
-	// 		name:  cTopic,
-	// 		dType: cType,
-	// 	}
-	// }
-
-	// cResp := C.Subscribe(cArray, totalConfigs, cTrig, (C.c_callback)(unsafe.Pointer(C.cgoFunc)), nil)
-	// goResp := C.GoString(cResp)
-	// if goResp != "0" {
-	// 	glog.Errorln("Response: ", goResp)
-	// 	panic(goResp)
-	// }
+	if totalConfigs <= 0 || totalConfigs > len(topicConfigs) {
+		panic("Invalid topic configs count: " + strconv.Itoa(totalConfigs))
+	}
+	dbOpcua.lockContext()
+	defer dbOpcua.contextMutex.RUnlock()
+	count := totalConfigs
+	sub := &subscription{
+		topics: topicConfigs[:count:count],
+		cStrs:  make([]*C.char, 0, 3*count),
+		ch:     make(chan Notification, 1024),
+		quit:   make(chan struct{}),
+		done:   make(chan struct{}),
+	}
+	sub.ring = C.notificationRingNew(C.size_t(notificationRingSize))
+	if sub.ring == nil {
+		panic("Notification ring allocation has failed")
+	}
+	// the C subscription may call back into the ring until the context is destroyed, which frees it
+	dbOpcua.subscriptions = append(dbOpcua.subscriptions, sub)
+
+	cTopicCfgs := C.malloc(C.size_t(count) * C.size_t(unsafe.Sizeof(C.struct_TopicConfig{})))
+	defer C.free(cTopicCfgs)
+	topicCfgs := (*[1<<30 - 1]C.struct_TopicConfig)(cTopicCfgs)[:count:count]
+	for idx, topic := range sub.topics {
+		topicCfgs[idx] = C.struct_TopicConfig{
+			ns:    C.CString(topic["ns"]),
+			name:  C.CString(topic["name"]),
+			dType: C.CString(topic["dType"]),
+		}
+		sub.cStrs = append(sub.cStrs, topicCfgs[idx].ns, topicCfgs[idx].name, topicCfgs[idx].dType)
+	}
+	cTrig := C.CString(trig)
+	defer C.free(unsafe.Pointer(cTrig))
 
+	cResp := C.SubscribeData(dbOpcua.context, (*C.struct_TopicConfig)(cTopicCfgs), C.uint(count), cTrig,
+		C.c_data_callback(C.notificationRingPush), unsafe.Pointer(sub.ring))
+	goResp := C.GoString(cResp)
+	if goResp != "0" {
+		close(sub.done)
+		glog.Errorln("Response: ", goResp)
+		panic(goResp)
+	}
+	go sub.drain()
+	ch = sub.ch
+	return
+}
+
+// drain moves the notifications of the ring to the channel until the ring is closed
+func (sub *subscription) drain() {
+	defer close(sub.done)
+	defer close(sub.ch)
+	buf := make([]byte, notificationRingSize)
+	recordSize := int(unsafe.Sizeof(C.struct_NotificationRecord{}))
+	var written C.size_t
+	var dropped C.uint64_t
+	for {
+		cResp := C.notificationRingDrain(sub.ring, unsafe.Pointer(&buf[0]), C.size_t(len(buf)), &written, &dropped)
+		if C.GoString(cResp) != "0" {
+			// the ring is closed and empty
+			return
+		}
+		if dropped > 0 {
+			glog.Warningf("%d notifications dropped, the ring of the subscription was full", uint64(dropped))
+		}
+		for offset := 0; offset < int(written); {
+			record := (*C.struct_NotificationRecord)(unsafe.Pointer(&buf[offset]))
+			data := buf[offset+recordSize : offset+recordSize+int(record.length)]
+			select {
+			case sub.ch <- sub.notification(record, data):
+			case <-sub.quit:
+				return
+			}
+			offset += int(record.size)
+		}
+	}
+}
+
+// notification converts a record of the ring and its data into a Notification
+func (sub *subscription) notification(record *C.struct_NotificationRecord, data []byte) Notification {
+	n := Notification{
+		DType:           C.GoString(&record.dType[0]),
+		IsArray:         record.isArray != 0,
+		SourceTimestamp: uaDateTime(int64(record.sourceTimestamp)),
+		ServerTimestamp: uaDateTime(int64(record.serverTimestamp)),
+		StatusCode:      uint32(record.statusCode),
+	}
+	if idx := int(record.topicIndex); idx < len(sub.topics) {
+		n.Ns = sub.topics[idx]["ns"]
+		n.Topic = sub.topics[idx]["name"]
+	}
+	n.Data = decodeData(n.DType, n.IsArray, data, int(record.count))
+	return n
+}
+
+// close stops the goroutine of the subscription once its C subscription is destroyed, and frees it
+func (sub *subscription) close() {
+	C.notificationRingClose(sub.ring)
+	<-sub.done
+	C.notificationRingFree(sub.ring)
+	free(sub.cStrs)
+}
+
+// uaDateTime converts an UA_DateTime into a time.Time, 0 into the zero time.Time
+func uaDateTime(ticks int64) time.Time {
+	if ticks == 0 {
+		return time.Time{}
+	}
+	return time.Unix(0, (ticks-uaDateTimeUnixEpoch)*100).UTC()
+}
+
+// valueSizes are the sizes of the C values of the value data types
+var valueSizes = map[string]int{"boolean": 1, "int32": 4, "int": 4, "int64": 8, "float": 4, "double": 8, "datetime": 8}
+
+// decodeData converts the data of a notification of dType into a string, a []byte, or a value or a slice
+// of values as encodeValues takes them. It returns nil for empty values and unknown data types
+func decodeData(dType string, isArray bool, data []byte, count int) interface{} {
+	switch dType {
+	case "string":
+		return string(data)
+	case "bytes":
+		return append(make([]byte, 0, len(data)), data...)
+	}
+	elemSize := valueSizes[dType]
+	if elemSize == 0 || (!isArray && len(data) < elemSize) {
+		return nil
+	}
+	// the data is a C array of the values, 8 bytes aligned in the buffer of the ring
+	if count > len(data)/elemSize {
+		count = len(data) / elemSize
+	}
+	var values interface{}
+	switch dType {
+	case "boolean":
+		v := make([]bool, count)
+		for i := range v {
+			v[i] = data[i] != 0
+		}
+		values = v
+	case "int32", "int":
+		v := make([]int32, count)
+		for i := range v {
+			v[i] = *(*int32)(unsafe.Pointer(&data[4*i]))
+		}
+		values = v
+	case "int64":
+		v := make([]int64, count)
+		for i := range v {
+			v[i] = *(*int64)(unsafe.Pointer(&data[8*i]))
+		}
+		values = v
+	case "float":
+		v := make([]float32, count)
+		for i := range v {
+			v[i] = *(*float32)(unsafe.Pointer(&data[4*i]))
+		}
+		values = v
+	case "double":
+		v := make([]float64, count)
+		for i := range v {
+			v[i] = *(*float64)(unsafe.Pointer(&data[8*i]))
+		}
+		values = v
+	case "datetime":
+		v := make([]time.Time, count)
+		for i := range v {
+			v[i] = uaDateTime(*(*int64)(unsafe.Pointer(&data[8*i])))
+		}
+		values = v
+	}
+	if isArray {
+		return values
+	}
+	return reflect.ValueOf(values).Index(0).Interface()
+}
+
+func (dbOpcua *dataBusOpcua) metrics() (metrics *Metrics, err error) {
+	defer errHandler("OPCUA Metrics Failed!!!", &err)
+	dbOpcua.lockContext()
+	defer dbOpcua.contextMutex.RUnlock()
+	var server C.struct_ServerMetrics
+	cResp := C.GetServerMetrics(dbOpcua.context, &server)
+	if !succeeded(cResp) {
+		goResp := C.GoString(cResp)
+		glog.Errorln("Response: ", goResp)
+		panic(goResp)
+	}
+	metrics = &Metrics{Server: ServerMetrics{
+		TopicCount:            uint64(server.topicCount),
+		CurrentChannelCount:   uint64(server.currentChannelCount),
+		CumulatedChannelCount: uint64(server.cumulatedChannelCount),
+		RejectedChannelCount:  uint64(server.rejectedChannelCount),
+		CurrentSessionCount:   uint64(server.currentSessionCount),
+		CumulatedSessionCount: uint64(server.cumulatedSessionCount),
+		RejectedSessionCount:  uint64(server.rejectedSessionCount),
+		SessionTimeoutCount:   uint64(server.sessionTimeoutCount),
+		SessionAbortCount:     uint64(server.sessionAbortCount),
+		RegistryLockWaits:     uint64(server.registryLockWaits),
+		RegistryLockWait:      time.Duration(server.registryLockWaitNs),
+	}}
+
+	// topics may be added between two calls, retry until they all fit
+	topics := make([]C.struct_TopicMetrics, server.topicCount+1)
+	var count C.size_t
+	for {
+		cResp = C.GetTopicMetrics(dbOpcua.context, &topics[0], C.size_t(len(topics)), &count)
+		if !succeeded(cResp) {
+			goResp := C.GoString(cResp)
+			glog.Errorln("Response: ", goResp)
+			panic(goResp)
+		}
+		if int(count) <= len(topics) {
+			break
+		}
+		topics = make([]C.struct_TopicMetrics, 2*int(count))
+	}
+	metrics.Topics = make([]TopicMetrics, count)
+	for i := range metrics.Topics {
+		topic := &topics[i]
+		metrics.Topics[i] = TopicMetrics{
+			Ns:           C.GoString(&topic.ns[0]),
+			Topic:        C.GoString(&topic.topic[0]),
+			PublishCount: uint64(topic.publishCount),
+			PublishBytes: uint64(topic.publishBytes),
+			Drops:        uint64(topic.drops),
+			LatencySum:   time.Duration(topic.latencySumNs),
+			LatencyMax:   time.Duration(topic.latencyMaxNs),
+			LatencyP50:   time.Duration(topic.latencyP50Ns),
+			LatencyP90:   time.Duration(topic.latencyP90Ns),
+			LatencyP99:   time.Duration(topic.latencyP99Ns),
+			LatencyP999:  time.Duration(topic.latencyP999Ns),
+		}
+	}
+	return
+}
+
+func (dbOpcua *dataBusOpcua) publishMetrics() (err error) {
+	defer errHandler("OPCUA PublishMetrics Failed!!!", &err)
+	dbOpcua.lockContext()
+	defer dbOpcua.contextMutex.RUnlock()
+	cResp := C.PublishMetrics(dbOpcua.context)
+	if !succeeded(cResp) {
+		goResp := C.GoString(cResp)
+		glog.Errorln("Response: ", goResp)
+		panic(goResp)
+	}
 	return
 }
 
@@ -164,6 +821,27 @@ func (dbOpcua *dataBusOpcua) stopTopic(topic string) (err error) {
 
 func (dbOpcua *dataBusOpcua) destroyContext() (err error) {
 	defer errHandler("OPCUA Context Termination Failed!!!", &err)
-	C.ContextDestroy()
+	// waits for the calls into the context in progress, the next ones fail
+	dbOpcua.contextMutex.Lock()
+	if dbOpcua.context == nil {
+		dbOpcua.contextMutex.Unlock()
+		return
+	}
+	for _, sub := range dbOpcua.subscriptions {
+		close(sub.quit)
+	}
+	C.ContextDestroy(dbOpcua.context)
+	dbOpcua.context = nil
+	// the calls holding a batch are done
+	for _, batch := range dbOpcua.batches {
+		batch.release()
+	}
+	dbOpcua.batches = nil
+	dbOpcua.contextMutex.Unlock()
+	// nothing is pushed into the rings anymore
+	for _, sub := range dbOpcua.subscriptions {
+		sub.close()
+	}
+	dbOpcua.subscriptions = nil
 	return
 }
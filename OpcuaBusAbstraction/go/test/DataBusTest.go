@@ -117,13 +117,14 @@ func main() {
 			}
 		}
 	} else if *direction == "SUB" {
-		glog.Info("opcua subscriber is not implemented...")
-		// eiiDatab.Subscribe(topicConfigs, len(topicConfigs) "START", cbFunc)
-		// time.Sleep(5 * time.Second)
+		err = eiiDatab.Subscribe(topicConfigs, len(topicConfigs), "START", cbFunc)
+		if err != nil {
+			panic(err)
+		}
 
-		// for i := 0; i < 200; i++ {
-		// 	time.Sleep(time.Second)
-		// }
+		for i := 0; i < 200; i++ {
+			time.Sleep(time.Second)
+		}
 	}
 	eiiDatab.ContextDestroy()
 }
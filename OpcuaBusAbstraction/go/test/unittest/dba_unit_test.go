@@ -28,6 +28,7 @@ import (
 	"os"
 	"reflect"
 	"strconv"
+	"sync"
 	"testing"
 	"time"
 
@@ -241,6 +242,295 @@ func TestSub(t *testing.T) {
 	fmt.Println("##################Sub alone Test completed ###################")
 }
 
+// Test case for the subscription channel in dev mode.
+// Checks if the notifications of the topics arrive on the channel in order, with their values converted to
+// the Go types of their dType, and if the channel is closed when the context is destroyed.
+// Test for SubscribeChannel API.
+func TestSubscribeChannelDevMode(t *testing.T) {
+	fmt.Println("################## SubscribeChannel Dev Mode Test ###################")
+	devConfig := func(direction string) map[string]string {
+		return map[string]string{
+			"endpoint":    "opcua://localhost:65035",
+			"direction":   direction,
+			"certFile":    "",
+			"privateFile": "",
+			"trustFile":   "",
+		}
+	}
+	topics := []map[string]string{
+		{"ns": "StreamManager", "name": "channel_results", "dType": "string"},
+		{"ns": "StreamManager", "name": "channel_values", "dType": "double[]"},
+	}
+
+	eiiDatabpub, err := databus.NewDataBus()
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err = eiiDatabpub.ContextCreate(devConfig("PUB")); err != nil {
+		t.Fatal(err)
+	}
+	defer eiiDatabpub.ContextDestroy()
+	eiiDatabpub.Publish(topics[0], "Hello Init")
+	eiiDatabpub.Publish(topics[1], []float64{1.5, 2.5})
+
+	eiiDatabsub, err := databus.NewDataBus()
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err = eiiDatabsub.ContextCreate(devConfig("SUB")); err != nil {
+		t.Fatal(err)
+	}
+	ch, err := eiiDatabsub.SubscribeChannel(topics, len(topics), "START")
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	received := map[string]databus.Notification{}
+	for len(received) < len(topics) {
+		n := <-ch
+		received[n.Topic] = n
+	}
+	if received["channel_results"].Data != "Hello Init" || received["channel_results"].SourceTimestamp.IsZero() {
+		t.Fatalf("Unexpected notification: %+v", received["channel_results"])
+	}
+	if !reflect.DeepEqual(received["channel_values"].Data, []float64{1.5, 2.5}) {
+		t.Fatalf("Unexpected notification: %+v", received["channel_values"])
+	}
+
+	// every published string is a new value, received in order
+	last := -1
+	for i := 0; i < 20; i++ {
+		eiiDatabpub.Publish(topics[0], fmt.Sprintf("Hello %d", i))
+		time.Sleep(50 * time.Millisecond)
+		for len(ch) > 0 {
+			n := <-ch
+			var value int
+			if _, err = fmt.Sscanf(n.Data.(string), "Hello %d", &value); err != nil || value <= last {
+				t.Fatalf("Unexpected notification: %+v", n)
+			}
+			last = value
+		}
+	}
+	if last < 0 {
+		t.Fatal("No notification received")
+	}
+
+	eiiDatabsub.ContextDestroy()
+	for range ch {
+	}
+	fmt.Println("################## SubscribeChannel Dev Mode Test completed ###################")
+}
+
+// topicsDevMode creates a publisher in dev mode and the handles of count string topics and a bytes topic on it
+func topicsDevMode(tb testing.TB, port int, count int) (databus.DataBus, []*databus.Topic, *databus.Topic) {
+	eiiDatabpub, err := databus.NewDataBus()
+	if err != nil {
+		tb.Fatal(err)
+	}
+	err = eiiDatabpub.ContextCreate(map[string]string{
+		"endpoint":    "opcua://localhost:" + strconv.Itoa(port),
+		"direction":   "PUB",
+		"certFile":    "",
+		"privateFile": "",
+		"trustFile":   "",
+	})
+	if err != nil {
+		tb.Fatal(err)
+	}
+	topics := make([]*databus.Topic, count)
+	for i := range topics {
+		topics[i], err = eiiDatabpub.Topic(map[string]string{"ns": "StreamManager", "name": "handle_results" + strconv.Itoa(i), "dType": "string"})
+		if err != nil {
+			tb.Fatal(err)
+		}
+	}
+	blobTopic, err := eiiDatabpub.Topic(map[string]string{"ns": "StreamManager", "name": "handle_blob", "dType": "bytes"})
+	if err != nil {
+		tb.Fatal(err)
+	}
+	return eiiDatabpub, topics, blobTopic
+}
+
+// Test case for topic handles in dev mode.
+// Checks if publishing on topic handles, alone or in a batch, doesn't allocate once the topics are registered.
+// Test for Topic, Topic.Publish, Topic.PublishString and PublishTopics APIs.
+func TestTopicPublishAllocsDevMode(t *testing.T) {
+	fmt.Println("################## Topic Publish Allocs Dev Mode Test ###################")
+	eiiDatabpub, topics, blobTopic := topicsDevMode(t, 65036, 3)
+	defer eiiDatabpub.ContextDestroy()
+	msg := []byte("classifier results")
+	blob := make([]byte, 4096)
+	batch := [][]byte{msg, msg, msg}
+
+	publish := func() {
+		if err := topics[0].Publish(msg); err != nil {
+			t.Fatal(err)
+		}
+		if err := topics[1].PublishString("classifier results"); err != nil {
+			t.Fatal(err)
+		}
+		if err := blobTopic.Publish(blob); err != nil {
+			t.Fatal(err)
+		}
+		if err := eiiDatabpub.PublishTopics(topics, batch); err != nil {
+			t.Fatal(err)
+		}
+	}
+	publish()
+	if allocs := testing.AllocsPerRun(1000, publish); allocs != 0 {
+		t.Fatalf("Publishing on topic handles allocates %v times", allocs)
+	}
+
+	if err := eiiDatabpub.PublishTopics(topics[:1], batch); err == nil {
+		t.Fatal("PublishTopics with a data count mismatch succeeded")
+	}
+	for _, topic := range topics {
+		topic.Close()
+	}
+	blobTopic.Close()
+	fmt.Println("################## Topic Publish Allocs Dev Mode Test completed ###################")
+}
+
+// Benchmark of publishing a message on a topic handle, expected to report 0 allocs/op.
+func BenchmarkTopicPublishDevMode(b *testing.B) {
+	eiiDatabpub, topics, _ := topicsDevMode(b, 65037, 1)
+	defer eiiDatabpub.ContextDestroy()
+	msg := []byte("classifier results")
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if err := topics[0].Publish(msg); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+// payload sizes of the publish benchmarks, up to the 60KB the opcua bus is used with
+var benchPayloadSizes = []int{100, 1024, 10 * 1024, 60 * 1024}
+
+// Benchmarks of the publish APIs for several payload sizes: Publish of a string and of a []byte through
+// the topic config map, Publish on a topic handle and PublishTopics of a batch of 3 topics.
+// Run with -benchmem to get allocs/op and B/op.
+func BenchmarkPublishPayloadsDevMode(b *testing.B) {
+	eiiDatabpub, topics, blobTopic := topicsDevMode(b, 65046, 3)
+	defer eiiDatabpub.ContextDestroy()
+	stringConfig := map[string]string{"ns": "StreamManager", "name": "handle_results0", "dType": "string"}
+	bytesConfig := map[string]string{"ns": "StreamManager", "name": "handle_blob", "dType": "bytes"}
+
+	for _, size := range benchPayloadSizes {
+		payload := make([]byte, size)
+		for i := range payload {
+			payload[i] = 'a' + byte(i%26)
+		}
+		payloadString := string(payload)
+		batch := [][]byte{payload, payload, payload}
+		run := func(name string, messages int, publish func() error) {
+			b.Run(name+"/"+strconv.Itoa(size)+"B", func(b *testing.B) {
+				b.SetBytes(int64(messages * size))
+				b.ReportAllocs()
+				for i := 0; i < b.N; i++ {
+					if err := publish(); err != nil {
+						b.Fatal(err)
+					}
+				}
+			})
+		}
+		run("Publish/string", 1, func() error { return eiiDatabpub.Publish(stringConfig, payloadString) })
+		run("Publish/bytes", 1, func() error { return eiiDatabpub.Publish(bytesConfig, payload) })
+		run("Topic.Publish", 1, func() error { return blobTopic.Publish(payload) })
+		run("PublishTopics", len(batch), func() error { return eiiDatabpub.PublishTopics(topics, batch) })
+	}
+}
+
+// Test case for destroying a publisher in dev mode while publishing.
+// Checks if the publishes in progress complete before the context is freed and the next ones fail.
+// Test for ContextDestroy API.
+func TestContextDestroyWhilePublishingDevMode(t *testing.T) {
+	eiiDatabpub, topics, blobTopic := topicsDevMode(t, 65052, 2)
+	msg := []byte("classifier results")
+	batch := [][]byte{msg, msg}
+
+	// each publisher publishes until it fails
+	var wg sync.WaitGroup
+	for i := 0; i < 4; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			for {
+				var err error
+				if i%2 == 0 {
+					err = eiiDatabpub.PublishTopics(topics, batch)
+				} else {
+					err = blobTopic.Publish(make([]byte, 1024))
+				}
+				if err != nil {
+					return
+				}
+			}
+		}(i)
+	}
+	time.Sleep(200 * time.Millisecond)
+	if err := eiiDatabpub.ContextDestroy(); err != nil {
+		t.Fatal(err)
+	}
+	wg.Wait()
+	if err := topics[0].Publish(msg); err == nil {
+		t.Fatal("Publish after ContextDestroy succeeded")
+	}
+	if _, err := eiiDatabpub.Metrics(); err == nil {
+		t.Fatal("Metrics after ContextDestroy succeeded")
+	}
+	for _, topic := range topics {
+		topic.Close()
+	}
+	blobTopic.Close()
+}
+
+// Test case for the metrics of a publisher in dev mode.
+// Checks if the publishes on topic handles are counted, and the metrics can be mirrored to the Diagnostics namespace.
+func TestMetricsDevMode(t *testing.T) {
+	eiiDatabpub, topics, blobTopic := topicsDevMode(t, 65043, 2)
+	defer eiiDatabpub.ContextDestroy()
+	msg := []byte("classifier results")
+	for i := 0; i < 5; i++ {
+		if err := topics[0].Publish(msg); err != nil {
+			t.Fatal(err)
+		}
+	}
+	if err := blobTopic.Publish(make([]byte, 100)); err != nil {
+		t.Fatal(err)
+	}
+
+	metrics, err := eiiDatabpub.Metrics()
+	if err != nil {
+		t.Fatal(err)
+	}
+	// topics[1] is never published to, so it isn't registered
+	if metrics.Server.TopicCount != 2 || len(metrics.Topics) != 2 {
+		t.Fatalf("Got %d topics and metrics of %d, expected 2", metrics.Server.TopicCount, len(metrics.Topics))
+	}
+	for _, topic := range metrics.Topics {
+		expectedCount, expectedBytes := uint64(5), uint64(5*len(msg))
+		if topic.Topic == "handle_blob" {
+			expectedCount, expectedBytes = 1, 100
+		}
+		if topic.Ns != "StreamManager" || topic.PublishCount != expectedCount || topic.PublishBytes != expectedBytes {
+			t.Errorf("Unexpected metrics of topic %s: %+v", topic.Topic, topic)
+		}
+		if topic.LatencyP50 > topic.LatencyP99 || topic.LatencyP99 > topic.LatencyMax || topic.LatencySum == 0 {
+			t.Errorf("Unexpected latencies of topic %s: %+v", topic.Topic, topic)
+		}
+	}
+
+	if err = eiiDatabpub.PublishMetrics(); err != nil {
+		t.Fatal(err)
+	}
+	metrics, err = eiiDatabpub.Metrics()
+	if err != nil || metrics.Server.TopicCount != 2 {
+		t.Fatalf("Diagnostics variables are counted as topics: %v, %+v", err, metrics)
+	}
+}
+
 // Test case for publish.
 // Checks if server publishing points on a topic is successful.
 // Test for Publish API.
@@ -95,6 +95,15 @@ class DataBus:
                  - "privateFile"     : server/client private key file
                  - "trustFile"       : ca cert used to sign server/client cert
                  - "trustedListSize" : number of trustFiles
+                 - "notifyOnWrite"   : optional, PUB only. If True, topics
+                                       are value-backed variables sampled by
+                                       the subscriptions only after a publish
+                 - "serverWorkers"   : optional, PUB only. Number of servers
+                                       sharing the port and serving the
+                                       subscribers in parallel, default 1
+                 - "dispatchWorkers" : optional, SUB only. Number of threads
+                                       running the callbacks, topics keep
+                                       their order, default 0
          @return Exception: raise Exception in case of errors
         '''
         try:
@@ -131,7 +140,11 @@ class DataBus:
                   - "ns"  : Namespace name
                   - "name": Topic name
                   - "type": Data type associated with the topic
-        @param  data(string)        data to be written to opcua variable
+        @param  data(string)        data to be written to opcua variable,
+                                    bytes-like data is written as a
+                                    ByteString and bool, int, float,
+                                    datetime or list data as values of the
+                                    topic dType, ex: double or int32[]
         @return Exception:  raise Exception in case of errors
         '''
 
@@ -143,6 +156,45 @@ class DataBus:
                     self.publish.__name__))
                 raise
 
+    def topic(self, topic_config):
+
+        '''! topic function creates a topic to publish on repeatedly, its
+             topic_config is encoded once and its publish(data) takes a str
+             or bytes-like data without holding the gil
+        @param  topic_config(dict)   opcua `struct TopicConfig` structure
+                                     of a "string" or "bytes" dType topic
+        @return topic: object with a publish(data) method raising Exception
+                       in case of errors
+        @return Exception:  raise Exception in case of errors
+        '''
+
+        if "opcua" in self.bus_type:
+            try:
+                return self.bus.new_topic(topic_config)
+            except Exception:
+                self.logger.exception("{} Failure!!!".format(
+                    self.topic.__name__))
+                raise
+        raise Exception("Not a supported bus_type")
+
+    def publish_batch(self, topic_configs, datas):
+
+        '''! publish_batch function for publishing datas[i] on
+             topic_configs[i] for all the topics with a single call into
+             the opcua server process
+        @param  topic_configs(list)  list of topic_config dicts, see publish
+        @param  datas(list)          data to be written to each opcua variable
+        @return Exception:  raise Exception in case of errors
+        '''
+
+        if "opcua" in self.bus_type:
+            try:
+                self.bus.send_batch(topic_configs, datas)
+            except Exception:
+                self.logger.exception("{} Failure!!!".format(
+                    self.publish_batch.__name__))
+                raise
+
     def subscribe(self, topic_config, topic_config_count, trig, call_bck=None):
 
         '''! subscribe function makes the subscription to the list of
@@ -156,7 +208,9 @@ class DataBus:
         @param  topic_configCount(int) length of topic_config array
         @param  trig(string)          opcua trigger ex: START | STOP
         @param  call_bck(c_callback)  callback that sends out the subscribed
-                                      data back to the caller
+                                      data back to the caller, as str for
+                                      string topics, bytes for bytes topics
+                                      and the values for value topics
         @return Exception:  raise Exception in case of errors
         '''
 
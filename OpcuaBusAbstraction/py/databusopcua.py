@@ -20,31 +20,38 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 """
 
+from datetime import datetime
+from functools import partial
 import open62541W
 
-# TODO: This brings in a limitation of multiple different contexts
-# if one wants to receive the callbacks registered for different
-# streams from a single process. Need to implement this better
-FUNC = None
-G_QUEUE = None
 
-
-def cb_func(topic, msg):
-    """callback function
+def cb_func(queue, topic, msg):
+    """callback function, bound to the queue of the subscribing context
     """
-    # TODO: Find the root cause for this behavior and fix it
-    # This is to address extra character that seems to come in the json
-    # formatted `msg` C string in pyx callback
-    # Here, number 123 and 125 refers to ascii values of "{" and "}"
-    # respectively
-    if msg[0] == 123 and msg[-1] != 125:
-        last_brace_index = msg.rfind(125)
-        msg_byte_arr = bytearray(msg)
-        # This is to ignore the 2 additional hex chars eg. \x01\x02
-        msg = bytes(msg_byte_arr[:last_brace_index+1])
-    msg = msg.decode("utf-8")
-    topic = topic.decode("utf-8")
-    G_QUEUE.put({"topic": topic, "data": msg})
+    queue.put({"topic": topic, "data": msg})
+
+
+class OpcuaTopic:
+    '''Publishes on a string or bytes topic of a databus OPCUA context, its
+    topic_config is encoded once'''
+
+    def __init__(self, log, topic):
+        self.logger = log
+        self.topic = topic
+
+    def publish(self, data):
+        '''
+        Publish data on the topic, the other python threads keep running
+        while it is copied into the opcua server
+        Arguments:
+            data: str or bytes-like (bytes, bytearray, memoryview) message
+        Return/Exception: Will raise Exception in case of errors
+        '''
+        err_msg = self.topic.publish(data)
+        py_error_msg = err_msg.decode()
+        if py_error_msg != "0":
+            self.logger.error("Topic.publish() API failed!")
+            raise Exception(py_error_msg)
 
 
 class DatabOpcua:
@@ -54,6 +61,7 @@ class DatabOpcua:
         self.logger = log
         self.direction = None
         self.dev_mode = False
+        self.context = None
 
     def create_context(self, context_config):
         '''Creates a new messagebus context
@@ -70,6 +78,15 @@ class DatabOpcua:
                 "cert_file"   : server/client certificate file
                 "private_file": server/client private key file
                 "trust_file"  : ca cert used to sign server/client cert
+                "notifyOnWrite": optional, PUB only. If True, topics are
+                                 value-backed variables sampled by the
+                                 subscriptions only after a publish
+                "serverWorkers": optional, PUB only. Number of servers
+                                 sharing the port and serving the
+                                 subscribers in parallel, default 1
+                "dispatchWorkers": optional, SUB only. Number of threads
+                                   running the callbacks, default 0 runs
+                                   them on the client thread
         Return/Exception: Will raise Exception in case of errors'''
         cert_file = context_config["certFile"]
         private_file = context_config["privateFile"]
@@ -82,11 +99,11 @@ class DatabOpcua:
         # Create default endpoint protocol for opcua from given endpoint
         endpoint = context_config["endpoint"]
 
-        err_msg = open62541W.ContextCreate(endpoint,
-                                           self.direction,
-                                           context_config["certFile"],
-                                           context_config["privateFile"],
-                                           [context_config["trustFile"]])
+        err_msg, self.context = open62541W.ContextCreate(
+            endpoint, self.direction, cert_file, private_file, trust_files,
+            context_config.get("notifyOnWrite", False),
+            int(context_config.get("serverWorkers", 0)),
+            int(context_config.get("dispatchWorkers", 0)))
         py_error_msg = err_msg.decode()
         if py_error_msg != "0":
             self.logger.error("ContextCreate() API failed!")
@@ -104,30 +121,83 @@ class DatabOpcua:
         Return/Exception: Will raise Exception in case of errors
         '''
 
+    def new_topic(self, topic_config):
+        '''
+        Creates a topic to publish on repeatedly
+        Arguments:
+            topic_config: topic_config for opcua, with topic name & it's type,
+                          string or bytes
+        Return: OpcuaTopic
+        Exception: Will raise Exception in case of errors
+        '''
+
+        if self.direction != "PUB":
+            raise Exception("Wrong Bus Direction!!!")
+        return OpcuaTopic(self.logger,
+                          open62541W.Topic(self.context, topic_config))
+
     def send(self, topic_config, data):
         '''
         Publish data on the topic
         Arguments:
             topic_config: topic_config for opcua, with topic name & it's type
-            data: actual message
+            data: actual message, str or bytes-like for binary data, or
+                  for value topics (dType boolean, int32, int64, float,
+                  double or datetime, suffixed with [] for arrays) a bool,
+                  number or datetime or a list of them
         Return/Exception: Will raise Exception in case of errors
         '''
 
         if self.direction == "PUB":
             # TODO: Support for different data types
             if isinstance(data, str):
-                try:
-                    err_msg = open62541W.Publish(topic_config, data)
-                    py_error_msg = err_msg.decode()
-                    if py_error_msg != "0":
-                        self.logger.error("Publish() API failed!")
-                        raise Exception(py_error_msg)
-                except Exception:
-                    self.logger.exception("{} Failure!!!".format(
-                        self.send.__name__))
-                    raise
+                publish = open62541W.Publish
+            elif isinstance(data, (bytes, bytearray, memoryview)):
+                # binary data is published as a ByteString
+                publish = open62541W.PublishBytes
+            elif isinstance(data, (bool, int, float, datetime, list, tuple)):
+                # published as values of the topic dType
+                publish = open62541W.PublishValues
             else:
                 raise Exception("Wrong Data Type!!!")
+            try:
+                err_msg = publish(self.context, topic_config, data)
+                py_error_msg = err_msg.decode()
+                if py_error_msg != "0":
+                    self.logger.error("Publish() API failed!")
+                    raise Exception(py_error_msg)
+            except Exception:
+                self.logger.exception("{} Failure!!!".format(
+                    self.send.__name__))
+                raise
+        else:
+            raise Exception("Wrong Bus Direction!!!")
+
+    def send_batch(self, topic_configs, datas):
+        '''
+        Publish datas[i] on topic_configs[i] for all the topics at once
+        Arguments:
+            topic_configs: list of topic_config for opcua
+            datas: list of actual messages
+        Return/Exception: Will raise Exception in case of errors
+        '''
+
+        if self.direction == "PUB":
+            if len(topic_configs) != len(datas):
+                raise Exception("Topic configs and data count mismatch!!!")
+            if not all(isinstance(data, str) for data in datas):
+                raise Exception("Wrong Data Type!!!")
+            try:
+                err_msg = open62541W.PublishBatch(self.context,
+                                                  topic_configs, datas)
+                py_error_msg = err_msg.decode()
+                if py_error_msg != "0":
+                    self.logger.error("PublishBatch() API failed!")
+                    raise Exception(py_error_msg)
+            except Exception:
+                self.logger.exception("{} Failure!!!".format(
+                    self.send_batch.__name__))
+                raise
         else:
             raise Exception("Wrong Bus Direction!!!")
 
@@ -141,10 +211,9 @@ class DatabOpcua:
         Return/Exception: Will raise Exception in case of errors'''
 
         if (self.direction == "SUB") and (trig == "START"):
-            global G_QUEUE
-            G_QUEUE = queue
-            err_msg = open62541W.Subscribe(topic_configs, topic_config_count,
-                                           trig, cb_func)
+            err_msg = open62541W.Subscribe(self.context, topic_configs,
+                                           topic_config_count, trig,
+                                           partial(cb_func, queue))
             py_error_msg = err_msg.decode()
             if py_error_msg != "0":
                 self.logger.error("Subscribe() API failed!")
@@ -189,7 +258,9 @@ class DatabOpcua:
     def destroy_context(self):
         '''Destroy the messagebus context'''
         try:
-            open62541W.ContextDestroy()
+            if self.context is not None:
+                open62541W.ContextDestroy(self.context)
+                self.context = None
             self.logger.debug("OPCUA context is Terminated")
         except Exception:
             self.logger.exception("{} Failure!!!".format(
@@ -1,3 +1,5 @@
+from libc.stdint cimport int64_t, uint32_t, uint64_t
+
 cdef extern from "DataBus.h":
     struct ContextConfig:
         char *endpoint;
@@ -6,18 +8,67 @@ cdef extern from "DataBus.h":
         char *privateFile;
         char **trustFile;
         size_t trustedListSize;
+        bint notifyOnWrite;
+        size_t serverWorkers;
+        size_t dispatchWorkers;
 
     struct TopicConfig:
         char *ns;
         char *name;
         char *dType;
 
+    struct DataBusContext
+
+    # an immutable, reference-counted buffer holding the value of a topic
+    struct Payload
+
+    enum: PUBLISH_DATA_SIZE
+
+    Payload* payloadNew(size_t length) nogil;
+
+    char* payloadData(Payload *payload) nogil;
+
     ctypedef void (*c_callback)(const char *topic, const char *data, void *pyFunc)
 
-    char* ContextCreate(ContextConfig cxtConfig);
+    struct SubscribedData:
+        const char *ns;
+        const char *topic;
+        const char *dType;
+        bint isArray;
+        const void *data;
+        size_t length;
+        size_t count;
+        int64_t sourceTimestamp;
+        int64_t serverTimestamp;
+        uint32_t statusCode;
+
+    struct DispatchCounters:
+        uint64_t enqueued;
+        uint64_t dispatched;
+        uint64_t dropped;
+        uint64_t depth;
+        uint64_t maxDepth;
+        uint64_t latencySumNs;
+        uint64_t latencyMaxNs;
+
+    ctypedef void (*c_data_callback)(const SubscribedData *data, void *userFunc)
+
+    char* ContextCreate(ContextConfig cxtConfig, DataBusContext **context);
+
+    char* Publish(DataBusContext *context, TopicConfig topicCfg, const char *data) nogil;
+
+    char* PublishBytes(DataBusContext *context, TopicConfig topicCfg, const unsigned char *buf, size_t len) nogil;
+
+    char* PublishValues(DataBusContext *context, TopicConfig topicCfg, const void *values, size_t count) nogil;
+
+    char* PublishBatch(DataBusContext *context, TopicConfig *topicCfgs, const char **data, const size_t *lens, size_t count) nogil;
+
+    char* PublishPayload(DataBusContext *context, TopicConfig topicCfg, Payload *payload) nogil;
+
+    char* Subscribe(DataBusContext *context, TopicConfig[] topicConfigs, unsigned int topicConfigCount, const char *trig, c_callback cb, void* pyxFunc);
 
-    char* Publish(TopicConfig topicCfg, const char *data);
+    char* SubscribeData(DataBusContext *context, TopicConfig[] topicConfigs, unsigned int topicConfigCount, const char *trig, c_data_callback cb, void *userFunc) nogil;
 
-    char* Subscribe(TopicConfig[] topicConfigs, unsigned int topicConfigCount, const char *trig, c_callback cb, void* pyxFunc);
+    char* GetDispatchCounters(DataBusContext *context, TopicConfig topicConfig, DispatchCounters *counters) nogil;
 
-    void ContextDestroy();
\ No newline at end of file
+    void ContextDestroy(DataBusContext *context) nogil;
\ No newline at end of file
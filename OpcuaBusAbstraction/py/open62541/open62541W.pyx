@@ -1,9 +1,86 @@
 cimport copen62541W
-from libc.stdlib cimport malloc, free
-from libc.string cimport strcpy, strlen
+from libc.stdlib cimport malloc, calloc, free
+from libc.string cimport memcpy, strcpy, strlen
+from libc.stdint cimport int32_t, int64_t
+from datetime import datetime, timedelta, timezone
 
-cdef copen62541W.TopicConfig *cTopicConfig
-gTopicConfigCount = 0
+cdef extern from "<pthread.h>" nogil:
+  ctypedef struct pthread_mutex_t:
+    pass
+  ctypedef struct pthread_cond_t:
+    pass
+  int pthread_mutex_init(pthread_mutex_t *mutex, const void *attr)
+  int pthread_mutex_destroy(pthread_mutex_t *mutex)
+  int pthread_mutex_lock(pthread_mutex_t *mutex)
+  int pthread_mutex_unlock(pthread_mutex_t *mutex)
+  int pthread_cond_init(pthread_cond_t *cond, const void *attr)
+  int pthread_cond_destroy(pthread_cond_t *cond)
+  int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
+  int pthread_cond_broadcast(pthread_cond_t *cond)
+
+cdef class Context:
+  """Handle of an opcua publisher or subscriber context created by ContextCreate"""
+  cdef copen62541W.DataBusContext *context
+  # subscribed topics, referred to by the client until the context is destroyed
+  cdef copen62541W.TopicConfig *topicConfigs
+  cdef unsigned int topicConfigCount
+  # keeps the subscriber callback alive while the client calls it
+  cdef object callback
+  # calls into the context in progress without the gil, destroy waits for
+  # them before freeing it
+  cdef pthread_mutex_t mutex
+  cdef pthread_cond_t idle
+  cdef size_t inFlight
+
+  def __cinit__(self):
+    pthread_mutex_init(&self.mutex, NULL)
+    pthread_cond_init(&self.idle, NULL)
+
+  def __dealloc__(self):
+    self.destroy()
+    pthread_cond_destroy(&self.idle)
+    pthread_mutex_destroy(&self.mutex)
+
+  cdef copen62541W.DataBusContext* enter(self) nogil:
+    """Returns the context for a call into it, to be given back to leave(),
+    NULL once destroyed, which the C functions reject as not instantiated"""
+    cdef copen62541W.DataBusContext *context
+    pthread_mutex_lock(&self.mutex)
+    context = self.context
+    if context != NULL:
+      self.inFlight += 1
+    pthread_mutex_unlock(&self.mutex)
+    return context
+
+  cdef void leave(self, copen62541W.DataBusContext *context) nogil:
+    if context == NULL:
+      return
+    pthread_mutex_lock(&self.mutex)
+    self.inFlight -= 1
+    if self.inFlight == 0:
+      pthread_cond_broadcast(&self.idle)
+    pthread_mutex_unlock(&self.mutex)
+
+  cdef destroy(self):
+    cdef copen62541W.DataBusContext *context
+    # the client thread takes the gil to call the callback, release it
+    # while waiting for the calls in progress and for that thread to exit
+    with nogil:
+      pthread_mutex_lock(&self.mutex)
+      context = self.context
+      self.context = NULL
+      while self.inFlight > 0:
+        pthread_cond_wait(&self.idle, &self.mutex)
+      pthread_mutex_unlock(&self.mutex)
+      copen62541W.ContextDestroy(context)
+    for i in range(self.topicConfigCount):
+      free(self.topicConfigs[i].ns)
+      free(self.topicConfigs[i].name)
+      free(self.topicConfigs[i].dType)
+    free(self.topicConfigs)
+    self.topicConfigs = NULL
+    self.topicConfigCount = 0
+    self.callback = None
 
 cdef char** to_cstring_array(list_str):
     cdef char **ret = <char **>malloc(len(list_str) * sizeof(char *))
@@ -13,7 +90,8 @@ cdef char** to_cstring_array(list_str):
         ret[i] = temp
     return ret
 
-def ContextCreate(endpoint, direction, certFile, privateFile, trustFiles):
+def ContextCreate(endpoint, direction, certFile, privateFile, trustFiles, notifyOnWrite=False,
+                  serverWorkers=0, dispatchWorkers=0):
   cdef copen62541W.ContextConfig contextConfig
   cdef bytes endpoint_bytes = endpoint.encode();
   cdef char *cendpoint = endpoint_bytes;
@@ -33,12 +111,16 @@ def ContextCreate(endpoint, direction, certFile, privateFile, trustFiles):
   contextConfig.privateFile = ckeyFile
   contextConfig.trustFile = to_cstring_array(trustFiles)
   contextConfig.trustedListSize = len(trustFiles)
+  contextConfig.notifyOnWrite = notifyOnWrite
+  contextConfig.serverWorkers = serverWorkers
+  contextConfig.dispatchWorkers = dispatchWorkers
 
-  val = copen62541W.ContextCreate(contextConfig)
+  ctx = Context()
+  val = copen62541W.ContextCreate(contextConfig, &ctx.context)
   free(contextConfig.trustFile)
-  return val
+  return val, ctx
 
-def Publish(topicConf, data):
+def Publish(Context ctx not None, topicConf, data):
   cdef copen62541W.TopicConfig topicConfig
 
   cdef bytes namespace_bytes = topicConf['ns'].encode();
@@ -56,13 +138,243 @@ def Publish(topicConf, data):
   topicConfig.ns = cnamespace
   topicConfig.name =  ctopic
   topicConfig.dType = cdtype
-  return copen62541W.Publish(topicConfig, cdata)
+  cdef char *val
+  cdef copen62541W.DataBusContext *context
+  with nogil:
+    context = ctx.enter()
+    val = copen62541W.Publish(context, topicConfig, cdata)
+    ctx.leave(context)
+  return val
+
+def PublishBytes(Context ctx not None, topicConf, const unsigned char[::1] data):
+  cdef copen62541W.TopicConfig topicConfig
+
+  cdef bytes namespace_bytes = topicConf['ns'].encode();
+  cdef bytes topic_bytes = topicConf['name'].encode();
+  cdef bytes dtype_bytes = topicConf['dType'].encode();
+
+  topicConfig.ns = namespace_bytes
+  topicConfig.name = topic_bytes
+  topicConfig.dType = dtype_bytes
+  # the buffer is read in place, the C side copies it
+  cdef const unsigned char *buf = NULL
+  cdef size_t length = data.shape[0]
+  if length > 0:
+    buf = &data[0]
+  cdef char *val
+  cdef copen62541W.DataBusContext *context
+  with nogil:
+    context = ctx.enter()
+    val = copen62541W.PublishBytes(context, topicConfig, buf, length)
+    ctx.leave(context)
+  return val
+
+cdef char* copyEncoded(value) except NULL:
+  cdef bytes value_bytes = value.encode()
+  cdef char *cvalue = <char *>malloc(len(value_bytes) + 1)
+  if cvalue == NULL:
+    raise MemoryError()
+  strcpy(cvalue, value_bytes)
+  return cvalue
+
+cdef char* publishTopicPayload(copen62541W.DataBusContext *context, copen62541W.TopicConfig topicConfig,
+                               const unsigned char *data, size_t length) nogil:
+  if length >= copen62541W.PUBLISH_DATA_SIZE:
+    length = copen62541W.PUBLISH_DATA_SIZE - 1
+  cdef copen62541W.Payload *payload = copen62541W.payloadNew(length)
+  if payload == NULL:
+    return "Payload allocation has failed"
+  if length > 0:
+    memcpy(copen62541W.payloadData(payload), data, length)
+  return copen62541W.PublishPayload(context, topicConfig, payload)
 
-cdef void pyxCallback(const char *topic, const char *data, void *func) with gil:
-  (<object>func)(topic, data)
+cdef class Topic:
+  """Handle of a string or bytes topic of a publisher context. The topic config is encoded once,
+  publish() copies the data into the server without holding the gil"""
+  cdef Context ctx
+  cdef copen62541W.TopicConfig topicConfig
+  cdef bint isBytes
+
+  def __cinit__(self, Context ctx not None, topicConf):
+    dtype = topicConf['dType'].lower()
+    if dtype not in ("string", "bytes"):
+      raise Exception("Unsupported topic dType: " + topicConf['dType'])
+    self.ctx = ctx
+    self.isBytes = dtype == "bytes"
+    self.topicConfig.ns = copyEncoded(topicConf['ns'])
+    self.topicConfig.name = copyEncoded(topicConf['name'])
+    self.topicConfig.dType = copyEncoded(topicConf['dType'])
+
+  def __dealloc__(self):
+    free(self.topicConfig.ns)
+    free(self.topicConfig.name)
+    free(self.topicConfig.dType)
 
-def Subscribe(topicConfigs, topicConfigCount, trig, pyFunc):
-  cTopicConfig = <copen62541W.TopicConfig *>malloc(topicConfigCount * sizeof(copen62541W.TopicConfig))
+  def publish(self, data):
+    """Publishes data, a str or a bytes-like object such as bytes, bytearray or a memoryview of
+    bytes, as a String on string topics and a ByteString on bytes topics. The buffer is read in
+    place, strings longer than PUBLISH_DATA_SIZE - 1 bytes are truncated"""
+    if isinstance(data, str):
+      data = data.encode()
+    cdef const unsigned char[::1] view = data
+    cdef const unsigned char *buf = NULL
+    cdef size_t length = view.shape[0]
+    if length > 0:
+      buf = &view[0]
+    cdef char *val
+    cdef copen62541W.DataBusContext *context
+    with nogil:
+      context = self.ctx.enter()
+      if self.isBytes:
+        val = copen62541W.PublishBytes(context, self.topicConfig, buf, length)
+      else:
+        val = publishTopicPayload(context, self.topicConfig, buf, length)
+      self.ctx.leave(context)
+    return val
+
+# the unix epoch as an UA_DateTime, in 100 ns intervals since 1601-01-01
+UA_DATETIME_UNIX_EPOCH = 116444736000000000
+UNIX_EPOCH = datetime(1970, 1, 1, tzinfo=timezone.utc)
+
+def PublishValues(Context ctx not None, topicConf, values):
+  cdef copen62541W.TopicConfig topicConfig
+
+  cdef bytes namespace_bytes = topicConf['ns'].encode();
+  cdef bytes topic_bytes = topicConf['name'].encode();
+  cdef bytes dtype_bytes = topicConf['dType'].encode();
+
+  topicConfig.ns = namespace_bytes
+  topicConfig.name = topic_bytes
+  topicConfig.dType = dtype_bytes
+
+  dtype = topicConf['dType'].lower()
+  if dtype.endswith("[]"):
+    dtype = dtype[:-2]
+  else:
+    values = [values]
+  if dtype == "boolean":
+    # UA_Boolean is a one byte C bool
+    elem_size = 1
+  elif dtype in ("int32", "int", "float"):
+    elem_size = 4
+  elif dtype in ("int64", "double", "datetime"):
+    elem_size = 8
+  else:
+    raise Exception("Wrong Data Type!!!")
+
+  cdef size_t count = len(values)
+  cdef char *val
+  cdef copen62541W.DataBusContext *context
+  cdef char *cvalues = <char *>malloc(count * elem_size + 1)
+  if cvalues == NULL:
+    raise MemoryError()
+  try:
+    for i, value in enumerate(values):
+      if dtype == "boolean":
+        (<unsigned char *>cvalues)[i] = 1 if value else 0
+      elif dtype == "float":
+        (<float *>cvalues)[i] = value
+      elif dtype == "double":
+        (<double *>cvalues)[i] = value
+      elif dtype == "int64":
+        (<int64_t *>cvalues)[i] = value
+      elif dtype == "datetime":
+        # naive datetimes are in local time, as datetime.timestamp() takes them
+        delta = value.astimezone(timezone.utc) - UNIX_EPOCH
+        (<int64_t *>cvalues)[i] = ((delta.days * 86400 + delta.seconds) * 10000000 +
+                                   delta.microseconds * 10 + UA_DATETIME_UNIX_EPOCH)
+      else:
+        (<int32_t *>cvalues)[i] = value
+    with nogil:
+      context = ctx.enter()
+      val = copen62541W.PublishValues(context, topicConfig, cvalues, count)
+      ctx.leave(context)
+    return val
+  finally:
+    free(cvalues)
+
+def PublishBatch(Context ctx not None, topicConfs, datas):
+  cdef size_t count = len(topicConfs)
+  if count == 0:
+    return b"0"
+  cdef copen62541W.TopicConfig *topicConfigs = <copen62541W.TopicConfig *>malloc(count * sizeof(copen62541W.TopicConfig))
+  cdef const char **cdata = <const char **>malloc(count * sizeof(char *))
+  cdef size_t *clens = <size_t *>malloc(count * sizeof(size_t))
+  # keeps the encoded bytes alive until PublishBatch() returns
+  cdef list keep = []
+  cdef bytes namespace_bytes
+  cdef bytes topic_bytes
+  cdef bytes dtype_bytes
+  cdef bytes data_bytes
+  cdef char *val
+  cdef copen62541W.DataBusContext *context
+
+  try:
+    for i in range(count):
+      namespace_bytes = topicConfs[i]['ns'].encode()
+      topic_bytes = topicConfs[i]['name'].encode()
+      dtype_bytes = topicConfs[i]['dType'].encode()
+      data_bytes = datas[i].encode()
+      keep.append((namespace_bytes, topic_bytes, dtype_bytes, data_bytes))
+
+      topicConfigs[i].ns = namespace_bytes
+      topicConfigs[i].name = topic_bytes
+      topicConfigs[i].dType = dtype_bytes
+      cdata[i] = data_bytes
+      clens[i] = len(data_bytes)
+
+    with nogil:
+      context = ctx.enter()
+      val = copen62541W.PublishBatch(context, topicConfigs, cdata, clens, count)
+      ctx.leave(context)
+    return val
+  finally:
+    free(topicConfigs)
+    free(cdata)
+    free(clens)
+
+cdef object subscribedValue(const copen62541W.SubscribedData *data):
+  """Converts the subscribed data into a str for string topics, bytes for bytes
+  topics, and a bool, int, float or datetime, or a list of them for arrays, for
+  value topics"""
+  cdef bytes dtype = data.dType
+  cdef const char *cdata = <const char *>data.data
+  if dtype == b"string":
+    return cdata[:data.length].decode("utf-8") if data.length > 0 else ""
+  if dtype == b"bytes":
+    return cdata[:data.length] if data.length > 0 else b""
+  values = []
+  for i in range(data.count):
+    if dtype == b"boolean":
+      values.append((<const unsigned char *>data.data)[i] != 0)
+    elif dtype == b"float":
+      values.append((<const float *>data.data)[i])
+    elif dtype == b"double":
+      values.append((<const double *>data.data)[i])
+    elif dtype == b"int64":
+      values.append((<const int64_t *>data.data)[i])
+    elif dtype == b"datetime":
+      values.append(UNIX_EPOCH + timedelta(
+        microseconds=((<const int64_t *>data.data)[i] - UA_DATETIME_UNIX_EPOCH) // 10))
+    else:
+      values.append((<const int32_t *>data.data)[i])
+  return values if data.isArray else values[0]
+
+cdef void pyxCallback(const copen62541W.SubscribedData *data, void *func) with gil:
+  # notifications without a value of a topic data type aren't handed over
+  if data.dType == NULL:
+    return
+  (<object>func)(data.topic.decode("utf-8"), subscribedValue(data))
+
+# pyFunc(topic, value) is called with each value converted by subscribedValue
+def Subscribe(Context ctx not None, topicConfigs, topicConfigCount, trig, pyFunc):
+  if ctx.topicConfigs is not NULL:
+    return b"Context is already subscribed"
+  cdef copen62541W.TopicConfig *cTopicConfig = <copen62541W.TopicConfig *>calloc(topicConfigCount, sizeof(copen62541W.TopicConfig))
+  if cTopicConfig is NULL:
+    raise MemoryError()
+  ctx.topicConfigs = cTopicConfig
+  ctx.topicConfigCount = topicConfigCount
   cdef bytes topic_bytes
   cdef char *ctopic
   cdef bytes namespace_bytes
@@ -90,19 +402,37 @@ def Subscribe(topicConfigs, topicConfigCount, trig, pyFunc):
   cdef bytes trig_bytes = trig.encode();
   cdef char *ctrig = trig_bytes;
 
-  val = copen62541W.Subscribe(cTopicConfig, topicConfigCount, ctrig, pyxCallback, <void *> pyFunc)
-  gTopicConfigCount = topicConfigCount
-
+  cdef void *cfunc = <void *> pyFunc
+  cdef unsigned int ccount = topicConfigCount
+  cdef char *val
+  cdef copen62541W.DataBusContext *context
+  ctx.callback = pyFunc
+  with nogil:
+    context = ctx.enter()
+    val = copen62541W.SubscribeData(context, cTopicConfig, ccount, ctrig, pyxCallback, cfunc)
+    ctx.leave(context)
   return val
 
-def ContextDestroy():
-  copen62541W.ContextDestroy()
-  for i in range(gTopicConfigCount):
-    if cTopicConfig[i].name is not NULL:
-      free(cTopicConfig[i].name)
-    if cTopicConfig[i].dType is not NULL:
-      free(cTopicConfig[i].dType)
+def DispatchCounters(Context ctx not None, topicConf):
+  cdef copen62541W.TopicConfig topicConfig
+  cdef copen62541W.DispatchCounters counters
+
+  cdef bytes namespace_bytes = topicConf['ns'].encode();
+  topicConfig.ns = namespace_bytes;
+  cdef bytes topic_bytes = topicConf['name'].encode();
+  topicConfig.name = topic_bytes;
+  cdef bytes dtype_bytes = topicConf['dType'].encode();
+  topicConfig.dType = dtype_bytes;
 
-  if cTopicConfig is not NULL:
-    free(cTopicConfig)
+  cdef char *val
+  cdef copen62541W.DataBusContext *context
+  with nogil:
+    context = ctx.enter()
+    val = copen62541W.GetDispatchCounters(context, topicConfig, &counters)
+    ctx.leave(context)
+  if val != b"0":
+    return val, None
+  return val, counters
 
+def ContextDestroy(Context ctx not None):
+  ctx.destroy()
@@ -277,6 +277,57 @@ class TestDBA(unittest.TestCase):
         print("########## Testing Context Destroy \
               Test Completed ##########\n\n")
 
+    def test_i_context_destroy_while_publishing(self):
+        """
+        Test case for context destroy while other threads publish
+        ContextDestroy waits for the publishes in progress and the
+            publishes after it are rejected instead of using the
+            destroyed context.
+        Expected Result: No crash, publishes after the destroy fail with
+            the not instantiated error.
+        """
+
+        import open62541W
+
+        print("########## Testing Context Destroy While Publishing \
+              Test ##########")
+        # the destroy races with the publishes in progress, repeat it
+        for _ in range(10):
+            err, ctx = open62541W.ContextCreate("opcua://localhost:65053",
+                                                "PUB", "", "", [""])
+            self.assertEqual(err, b"0")
+            topics = [open62541W.Topic(ctx, {"ns": "StreamManager",
+                                             "name": "destroy_" + str(i),
+                                             "dType": "string"})
+                      for i in range(4)]
+            errors = [[] for _ in topics]
+            destroyed = threading.Event()
+
+            def publish(index):
+                while True:
+                    done = destroyed.is_set()
+                    val = topics[index].publish("destroy while publishing")
+                    if val != b"0":
+                        errors[index].append(val)
+                    if done:
+                        break
+
+            threads = [threading.Thread(target=publish, args=(i,))
+                       for i in range(len(topics))]
+            for thread in threads:
+                thread.start()
+            time.sleep(0.05)
+            open62541W.ContextDestroy(ctx)
+            destroyed.set()
+            for thread in threads:
+                thread.join()
+
+            for topic_errors in errors:
+                self.assertEqual(topic_errors[-1],
+                                 b"UA_Server instance is not instantiated")
+        print("########## Testing Context Destroy While Publishing \
+              Test Completed ##########\n\n")
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -27,12 +27,21 @@ import (
 	eiimsgbus "github.com/open-edge-insights/eii-messagebus-go/eiimsgbus"
 	databus "opcuabusobstraction/go"
 
+	"bytes"
 	"encoding/base64"
 	"flag"
 	"fmt"
 	"io/ioutil"
+	"net"
+	"net/http"
 	"os"
+	"os/signal"
+	"strconv"
 	"strings"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
 
 	"github.com/golang/glog"
 )
@@ -40,13 +49,108 @@ import (
 // OpcuaExportApp interface
 type OpcuaExportApp interface {
 	Subscribe()
-	Publish(data interface{})
+	Publish(route *opcuaRoute, data interface{})
+	PublishBlobs(route *opcuaRoute, blobs [][]byte)
 }
 
 // struct for opcuaBus related configurations
 type opcuaBus struct {
 	opcuaDatab databus.DataBus
 	pubTopics  []string
+	// handles of pubTopics and of their blob topics, blobTopics[i][j] publishing blob j on pubTopics[i]
+	topics     []*databus.Topic
+	blobTopics [][]*databus.Topic
+	// indexes in pubTopics of the opcua topics of each "<subscriber>/<topic>" of OpcuaRoutes, nil
+	// when the legacy OpcuaDatabusTopics is configured and every message goes to all pubTopics
+	routeTopics map[string][]int
+	// "<subscriber>/<topic>" of the OpcuaRoutes whose blob frames are published too
+	routeBlobs map[string]bool
+	routed     map[string]bool
+	routes     []*opcuaRoute
+	// capacity and overload policy of the publish queue of each route
+	queueSize      int
+	overloadPolicy string
+	// period of the summary logs of the routes
+	summaryInterval time.Duration
+	// address the Prometheus metrics are served on and period of their mirror to the Diagnostics
+	// folder of the opcua server, disabled if empty or 0
+	metricsEndpoint     string
+	diagnosticsInterval time.Duration
+	// guards blobTopics, which are shared by the routes publishing to the same opcua topics
+	blobMutex sync.RWMutex
+}
+
+// opcuaRoute is the routing of the messages of one msgbus (subscriber, topic) to its opcua topics,
+// resolved once at startup
+type opcuaRoute struct {
+	// counters of the publish queue and of the blobs skipped for their size, first for the alignment
+	// of atomic accesses
+	dropped   uint64
+	highWater uint64
+	oversized uint64
+	// bounded queue of the received messages, published by the publisher goroutine of the route
+	queue chan queuedMessage
+	// publish counters since the last summary log and time of the last error log, guarded by the mutex
+	mutex        sync.Mutex
+	stats        publishStats
+	lastErrorLog time.Time
+	// time of the last sampled data log, used by the publisher goroutine only
+	lastSample time.Time
+
+	subscriber   string
+	topic        string
+	publishBlobs bool
+	pubIndexes   []int
+	pubTopics    []string
+	topics       []*databus.Topic
+	// buffers of the formatted data and of the "<opcua topic> <data>" messages, reused by every Publish
+	formatted bytes.Buffer
+	messages  [][]byte
+}
+
+// queuedMessage is a received message with its time of reception
+type queuedMessage struct {
+	msg      *eiimsgbus.MsgEnvelope
+	received time.Time
+}
+
+// publishStats are the publish counters of a route over a summary interval
+type publishStats struct {
+	messages   uint64
+	bytes      uint64
+	errors     uint64
+	maxLatency time.Duration
+}
+
+// overload policies of the publish queues, applied to a message received when its queue is full
+const (
+	dropOldest = "drop-oldest"
+	dropNewest = "drop-newest"
+	block      = "block"
+)
+
+const (
+	defaultQueueSize = 64
+	// drops like config.json, a blocked receive loop would leave the backlog to the message bus
+	defaultOverloadPolicy = dropOldest
+	// default period of the summary logs of the routes, giving their published messages and bytes,
+	// max latency and dropped messages
+	defaultSummaryInterval = 10 * time.Second
+	// minimum period between two logs of the data published, at verbosity 1, or of the publish
+	// errors of a route
+	logSampleInterval = time.Second
+)
+
+// PublishQueueStats are the counters of the publish queue of a route, and of its blobs skipped for
+// exceeding the publish size limit
+type PublishQueueStats struct {
+	Subscriber     string
+	Topic          string
+	Length         int
+	Capacity       int
+	HighWater      int
+	Dropped        uint64
+	OversizedBlobs uint64
 }
 
 // OpcuaExport struct with both opcuaBus and messageBus configurations
@@ -77,14 +181,34 @@ func NewOpcuaExport() (opcuaExport *OpcuaExport, err error) {
 		fmt.Println("Error found to get app config for Opcua:", err)
 	}
 
-	//creating a list of string from a list of interface.
-	interfaceList := appConfig["OpcuaDatabusTopics"].([]interface{})
-	lenList := len(interfaceList)
-	publishTopics := make([]string, lenList)
-	for index, data := range interfaceList {
-		publishTopics[index] = data.(string)
+	err = opcuaExport.opcuaBus.parseRoutes(appConfig)
+	if err != nil {
+		glog.Errorf("Opcua routes config Error: %v", err)
+		return opcuaExport, err
+	}
+
+	err = opcuaExport.opcuaBus.parsePublishQueue(appConfig)
+	if err != nil {
+		glog.Errorf("Publish queue config Error: %v", err)
+		return opcuaExport, err
+	}
+
+	opcuaExport.opcuaBus.summaryInterval = defaultSummaryInterval
+	if interval, ok := appConfig["LogSummaryInterval"]; ok {
+		seconds, ok := interval.(float64)
+		if !ok || seconds <= 0 {
+			err = fmt.Errorf("LogSummaryInterval %v is not a positive number of seconds", interval)
+			glog.Errorf("Log config Error: %v", err)
+			return opcuaExport, err
+		}
+		opcuaExport.opcuaBus.summaryInterval = time.Duration(seconds * float64(time.Second))
+	}
+
+	err = opcuaExport.opcuaBus.parseMetrics(appConfig, opcuaExport.devMode)
+	if err != nil {
+		glog.Errorf("Metrics config Error: %v", err)
+		return opcuaExport, err
 	}
-	opcuaExport.opcuaBus.pubTopics = publishTopics
 
 	OpcuaExportCfg := appConfig["OpcuaExportCfg"].(string)
 	pubConfigList := strings.Split(OpcuaExportCfg, ",")
@@ -133,6 +257,11 @@ func NewOpcuaExport() (opcuaExport *OpcuaExport, err error) {
 		return opcuaExport, err
 	}
 
+	err = opcuaExport.opcuaBus.createTopics()
+	if err != nil {
+		return opcuaExport, err
+	}
+
 	for _, opcuaCert := range opcuaCerts {
 		_, statErr := os.Stat(opcuaCert)
 		if statErr == nil {
@@ -146,7 +275,217 @@ func NewOpcuaExport() (opcuaExport *OpcuaExport, err error) {
 	return opcuaExport, err
 }
 
-// Subscribe function spawns worker thread to subscribe to EII message bus and starts publishing data to opcua
+// createTopics creates the handles of pubTopics, their blob topics being created on their first blob
+func (bus *opcuaBus) createTopics() error {
+	bus.topics = make([]*databus.Topic, len(bus.pubTopics))
+	bus.blobTopics = make([][]*databus.Topic, len(bus.pubTopics))
+	for i, pubTopic := range bus.pubTopics {
+		var err error
+		topicConfig := map[string]string{"ns": "StreamManager", "name": pubTopic, "dType": "string"}
+		bus.topics[i], err = bus.opcuaDatab.Topic(topicConfig)
+		if err != nil {
+			glog.Errorf("DataBus-OPCUA topic creation Error: %v on topic: %v", err, pubTopic)
+			return err
+		}
+	}
+	return nil
+}
+
+// parseRoutes reads the opcua topics and the routes to them from the app config. "OpcuaRoutes" maps
+// each msgbus (subscriber, topic) to its opcua topics, while the legacy "OpcuaDatabusTopics" lists
+// opcua topics receiving every message
+func (bus *opcuaBus) parseRoutes(appConfig map[string]interface{}) error {
+	routesCfg, ok := appConfig["OpcuaRoutes"]
+	if !ok {
+		pubTopics, ok := appConfig["OpcuaDatabusTopics"].([]interface{})
+		if !ok {
+			return fmt.Errorf("neither OpcuaRoutes nor OpcuaDatabusTopics list is configured")
+		}
+		for _, pubTopic := range pubTopics {
+			name, ok := pubTopic.(string)
+			if !ok {
+				return fmt.Errorf("OpcuaDatabusTopics entry %v is not a string", pubTopic)
+			}
+			bus.pubTopicIndex(name)
+		}
+		return nil
+	}
+
+	routes, ok := routesCfg.([]interface{})
+	if !ok {
+		return fmt.Errorf("OpcuaRoutes is not a list")
+	}
+	bus.routeTopics = make(map[string][]int)
+	bus.routeBlobs = make(map[string]bool)
+	bus.routed = make(map[string]bool)
+	for _, routeCfg := range routes {
+		route, ok := routeCfg.(map[string]interface{})
+		subscriber, okSubscriber := route["Subscriber"].(string)
+		topic, okTopic := route["Topic"].(string)
+		pubTopics, okPubTopics := route["OpcuaTopics"].([]interface{})
+		if !ok || !okSubscriber || !okTopic || !okPubTopics {
+			return fmt.Errorf("OpcuaRoutes entry %v needs Subscriber, Topic and OpcuaTopics", routeCfg)
+		}
+		key := subscriber + "/" + topic
+		if blobsCfg, ok := route["PublishBlobs"]; ok {
+			blobs, ok := blobsCfg.(bool)
+			if !ok {
+				return fmt.Errorf("PublishBlobs %v of route %s is not a boolean", blobsCfg, key)
+			}
+			bus.routeBlobs[key] = bus.routeBlobs[key] || blobs
+		}
+		for _, pubTopic := range pubTopics {
+			name, ok := pubTopic.(string)
+			if !ok {
+				return fmt.Errorf("OpcuaTopics entry %v of route %s is not a string", pubTopic, key)
+			}
+			index := bus.pubTopicIndex(name)
+			if !containsIndex(bus.routeTopics[key], index) {
+				bus.routeTopics[key] = append(bus.routeTopics[key], index)
+			}
+		}
+	}
+	return nil
+}
+
+// parsePublishQueue reads the optional "PublishQueue" config, {"Size": <messages>, "OverloadPolicy":
+// "drop-oldest" | "drop-newest" | "block"}, of the queues between the msgbus receive loops and the
+// opcua publishers
+func (bus *opcuaBus) parsePublishQueue(appConfig map[string]interface{}) error {
+	bus.queueSize = defaultQueueSize
+	bus.overloadPolicy = defaultOverloadPolicy
+	queueCfg, ok := appConfig["PublishQueue"]
+	if !ok {
+		return nil
+	}
+	queue, ok := queueCfg.(map[string]interface{})
+	if !ok {
+		return fmt.Errorf("PublishQueue is not an object")
+	}
+	if size, ok := queue["Size"]; ok {
+		value, ok := size.(float64)
+		if !ok || value < 1 || value != float64(int(value)) {
+			return fmt.Errorf("PublishQueue Size %v is not a positive integer", size)
+		}
+		bus.queueSize = int(value)
+	}
+	if policy, ok := queue["OverloadPolicy"]; ok {
+		value, _ := policy.(string)
+		switch value {
+		case dropOldest, dropNewest, block:
+			bus.overloadPolicy = value
+		default:
+			return fmt.Errorf("PublishQueue OverloadPolicy %v is not one of %s, %s, %s", policy, dropOldest, dropNewest, block)
+		}
+	}
+	return nil
+}
+
+// parseMetrics reads the optional "Metrics" config, {"Endpoint": "<host>:<port>", "DiagnosticsInterval":
+// <seconds>}, of the Prometheus metrics endpoint and of the mirror of the metrics to the opcua server.
+// The endpoint is served over plain HTTP without authentication, so in prod mode it has to be a loopback address
+func (bus *opcuaBus) parseMetrics(appConfig map[string]interface{}, devMode bool) error {
+	metricsCfg, ok := appConfig["Metrics"]
+	if !ok {
+		return nil
+	}
+	metrics, ok := metricsCfg.(map[string]interface{})
+	if !ok {
+		return fmt.Errorf("Metrics is not an object")
+	}
+	if endpoint, ok := metrics["Endpoint"]; ok {
+		bus.metricsEndpoint, ok = endpoint.(string)
+		if !ok {
+			return fmt.Errorf("Metrics Endpoint %v is not a string", endpoint)
+		}
+		if bus.metricsEndpoint != "" && !devMode && !isLoopback(bus.metricsEndpoint) {
+			return fmt.Errorf("Metrics Endpoint %s is not a loopback address, the metrics are not served "+
+				"over an authenticated channel in prod mode", bus.metricsEndpoint)
+		}
+	}
+	if interval, ok := metrics["DiagnosticsInterval"]; ok {
+		seconds, ok := interval.(float64)
+		if !ok || seconds < 0 {
+			return fmt.Errorf("Metrics DiagnosticsInterval %v is not a number of seconds", interval)
+		}
+		bus.diagnosticsInterval = time.Duration(seconds * float64(time.Second))
+	}
+	return nil
+}
+
+// isLoopback returns whether the "<host>:<port>" address listens on a loopback interface only
+func isLoopback(address string) bool {
+	host, _, err := net.SplitHostPort(address)
+	if err != nil {
+		return false
+	}
+	if host == "localhost" {
+		return true
+	}
+	ip := net.ParseIP(host)
+	return ip != nil && ip.IsLoopback()
+}
+
+// pubTopicIndex returns the index of the opcua topic name in pubTopics, adding it when new
+func (bus *opcuaBus) pubTopicIndex(name string) int {
+	for i, pubTopic := range bus.pubTopics {
+		if pubTopic == name {
+			return i
+		}
+	}
+	bus.pubTopics = append(bus.pubTopics, name)
+	return len(bus.pubTopics) - 1
+}
+
+func containsIndex(indexes []int, index int) bool {
+	for _, i := range indexes {
+		if i == index {
+			return true
+		}
+	}
+	return false
+}
+
+// newRoute resolves the opcua topics the messages of topic from the subscriber are published on,
+// nil when none is configured
+func (bus *opcuaBus) newRoute(subscriber string, topic string) *opcuaRoute {
+	var pubIndexes []int
+	publishBlobs := false
+	if bus.routeTopics == nil {
+		pubIndexes = make([]int, len(bus.pubTopics))
+		for i := range pubIndexes {
+			pubIndexes[i] = i
+		}
+	} else {
+		key := subscriber + "/" + topic
+		pubIndexes = bus.routeTopics[key]
+		publishBlobs = bus.routeBlobs[key]
+		bus.routed[key] = true
+	}
+	if len(pubIndexes) == 0 {
+		return nil
+	}
+
+	route := &opcuaRoute{
+		subscriber:   subscriber,
+		topic:        topic,
+		publishBlobs: publishBlobs,
+		pubIndexes:   pubIndexes,
+		pubTopics:    make([]string, len(pubIndexes)),
+		topics:       make([]*databus.Topic, len(pubIndexes)),
+		messages:     make([][]byte, len(pubIndexes)),
+		queue:        make(chan queuedMessage, bus.queueSize),
+	}
+	for i, pubIndex := range pubIndexes {
+		route.pubTopics[i] = bus.pubTopics[pubIndex]
+		route.topics[i] = bus.topics[pubIndex]
+	}
+	bus.routes = append(bus.routes, route)
+	return route
+}
+
+// Subscribe function spawns a worker thread per subscriber to subscribe to its routed topics on EII
+// message bus and starts publishing data to opcua
 func (opcuaExport *OpcuaExport) Subscribe() {
 	glog.Infof("-- Initializing message bus context")
 	defer opcuaExport.configMgr.Destroy()
@@ -170,50 +509,453 @@ func (opcuaExport *OpcuaExport) Subscribe() {
 			glog.Errorf("Failed to fetch msgbus config : %v", err)
 			return
 		}
-		go worker(opcuaExport, config, subTopics[0])
+
+		name := ""
+		if opcuaExport.opcuaBus.routeTopics != nil {
+			nameValue, err := subctx.GetInterfaceValue("Name")
+			if err == nil {
+				name, err = nameValue.GetString()
+			}
+			if err != nil {
+				glog.Errorf("Failed to fetch subscriber name : %v", err)
+				return
+			}
+		}
+
+		routes := make([]*opcuaRoute, 0, len(subTopics))
+		for _, subTopic := range subTopics {
+			route := opcuaExport.opcuaBus.newRoute(name, subTopic)
+			if route == nil {
+				glog.Warningf("No opcua topic is routed from topic: %s of subscriber: %s, not subscribing to it", subTopic, name)
+				continue
+			}
+			routes = append(routes, route)
+		}
+		if len(routes) > 0 {
+			go worker(opcuaExport, config, routes)
+		}
 		subctx.Destroy()
 	}
-	
-}
 
-func worker(opcuaExport *OpcuaExport, config map[string]interface{}, topic string) {
-	defer opcuaExport.opcuaBus.opcuaDatab.ContextDestroy()
+	for key := range opcuaExport.opcuaBus.routeTopics {
+		if !opcuaExport.opcuaBus.routed[key] {
+			glog.Warningf("Opcua route from: %s matches no configured subscriber topic", key)
+		}
+	}
+	go opcuaExport.reportRoutes()
+	if opcuaExport.opcuaBus.metricsEndpoint != "" {
+		go opcuaExport.serveMetrics()
+	}
+	if opcuaExport.opcuaBus.diagnosticsInterval > 0 {
+		go opcuaExport.mirrorDiagnostics()
+	}
+}
 
+// worker subscribes to the topics of routes on one msgbus client, receiving the messages of each
+// topic in its own goroutine. Once the subscribers are closed it returns after its publishers have
+// published the queued messages, the opcua context being shared by all the workers
+func worker(opcuaExport *OpcuaExport, config map[string]interface{}, routes []*opcuaRoute) {
 	client, err := eiimsgbus.NewMsgbusClient(config)
 	if err != nil {
 		glog.Errorf("-- Error initializing message bus context: %v\n", err)
 		return
 	}
 	defer client.Close()
-	subscriber, err := client.NewSubscriber(topic)
-	if err != nil {
-		glog.Errorf("-- Error subscribing to topic: %v\n", err)
-		return
+
+	var receivers, publishers sync.WaitGroup
+	for _, route := range routes {
+		subscriber, err := client.NewSubscriber(route.topic)
+		if err != nil {
+			glog.Errorf("-- Error subscribing to topic: %s: %v\n", route.topic, err)
+			continue
+		}
+		defer subscriber.Close()
+		receivers.Add(1)
+		go receive(opcuaExport, subscriber, route, &receivers)
+		publishers.Add(1)
+		go func(route *opcuaRoute) {
+			defer publishers.Done()
+			publisher(opcuaExport, route)
+		}(route)
+	}
+	receivers.Wait()
+	// the receive loops were the only senders, the publishers stop once the queues are drained
+	for _, route := range routes {
+		close(route.queue)
 	}
-	defer subscriber.Close()
+	publishers.Wait()
+}
 
+func receive(opcuaExport *OpcuaExport, subscriber *eiimsgbus.Subscriber, route *opcuaRoute, wg *sync.WaitGroup) {
+	defer wg.Done()
 	for {
 		select {
-		case msg := <-subscriber.MessageChannel:
-			glog.V(1).Infof("-- Received Message: %v\n", msg.Data)
-			opcuaExport.Publish(msg.Data)
+		case msg, ok := <-subscriber.MessageChannel:
+			if !ok {
+				return
+			}
+			if glog.V(2) {
+				glog.Infof("-- Received Message: %v on topic: %s\n", msg.Data, route.topic)
+			}
+			opcuaExport.enqueue(route, queuedMessage{msg, time.Now()})
 		case err := <-subscriber.ErrorChannel:
-			glog.Errorf("-- Error receiving message: %v\n", err)
+			glog.Errorf("-- Error receiving message: %v on topic: %s\n", err, route.topic)
+		}
+	}
+}
+
+// enqueue queues the message for the publisher of the route. When the queue is full the overload
+// policy drops the oldest queued message, drops this message or blocks until there is room
+func (opcuaExport *OpcuaExport) enqueue(route *opcuaRoute, msg queuedMessage) {
+	switch opcuaExport.opcuaBus.overloadPolicy {
+	case block:
+		route.queue <- msg
+	case dropNewest:
+		select {
+		case route.queue <- msg:
+		default:
+			atomic.AddUint64(&route.dropped, 1)
+		}
+	default:
+		// the receive loop is the only sender, so room made here stays until the send
+		for sent := false; !sent; {
+			select {
+			case route.queue <- msg:
+				sent = true
+			default:
+				select {
+				case <-route.queue:
+					atomic.AddUint64(&route.dropped, 1)
+				default:
+				}
+			}
+		}
+	}
+	if length := uint64(len(route.queue)); length > atomic.LoadUint64(&route.highWater) {
+		atomic.StoreUint64(&route.highWater, length)
+	}
+}
+
+// publisher publishes the messages queued on the route, counting their latency from their reception.
+// The publishers of the routes run in parallel, each route being published by its publisher only
+func publisher(opcuaExport *OpcuaExport, route *opcuaRoute) {
+	for queued := range route.queue {
+		opcuaExport.Publish(route, queued.msg.Data)
+		if route.publishBlobs {
+			opcuaExport.PublishBlobs(route, queued.msg.Blob)
+		}
+
+		latency := time.Since(queued.received)
+		route.mutex.Lock()
+		route.stats.messages++
+		if latency > route.stats.maxLatency {
+			route.stats.maxLatency = latency
+		}
+		route.mutex.Unlock()
+	}
+}
+
+// publishError logs the publish error of the route unless another one was logged less than
+// logSampleInterval ago, every error being counted in the summary
+func (route *opcuaRoute) publishError(err error, topic string) {
+	route.mutex.Lock()
+	route.stats.errors++
+	errors := route.stats.errors
+	now := time.Now()
+	logged := now.Sub(route.lastErrorLog) >= logSampleInterval
+	if logged {
+		route.lastErrorLog = now
+	}
+	route.mutex.Unlock()
+	if logged {
+		glog.Errorf("Publish Error: %v on topic: %s (%d errors of topic: %s in this summary interval)",
+			err, topic, errors, route.topic)
+	}
+}
+
+// addBytes counts size bytes published by the route
+func (route *opcuaRoute) addBytes(size int) {
+	route.mutex.Lock()
+	route.stats.bytes += uint64(size)
+	route.mutex.Unlock()
+}
+
+// PublishQueueStats returns the counters of the publish queue of each subscribed route
+func (opcuaExport *OpcuaExport) PublishQueueStats() []PublishQueueStats {
+	routes := opcuaExport.opcuaBus.routes
+	stats := make([]PublishQueueStats, len(routes))
+	for i, route := range routes {
+		stats[i] = PublishQueueStats{
+			Subscriber:     route.subscriber,
+			Topic:          route.topic,
+			Length:         len(route.queue),
+			Capacity:       cap(route.queue),
+			HighWater:      int(atomic.LoadUint64(&route.highWater)),
+			Dropped:        atomic.LoadUint64(&route.dropped),
+			OversizedBlobs: atomic.LoadUint64(&route.oversized),
+		}
+	}
+	return stats
+}
+
+// reportRoutes logs every summaryInterval a summary line per route which published messages, the
+// publish queues which dropped messages and the routes which skipped oversized blobs since the last report
+func (opcuaExport *OpcuaExport) reportRoutes() {
+	bus := &opcuaExport.opcuaBus
+	reported := make([]uint64, len(bus.routes))
+	reportedOversized := make([]uint64, len(bus.routes))
+	for range time.Tick(bus.summaryInterval) {
+		for i, route := range bus.routes {
+			route.mutex.Lock()
+			stats := route.stats
+			route.stats = publishStats{}
+			route.mutex.Unlock()
+			if stats.messages > 0 || stats.errors > 0 {
+				glog.Infof("Topic: %s of subscriber: %s published %d messages, %d bytes on topics: %v in %v, max latency %v, %d errors",
+					route.topic, route.subscriber, stats.messages, stats.bytes, route.pubTopics, bus.summaryInterval,
+					stats.maxLatency, stats.errors)
+			}
+
+			dropped := atomic.LoadUint64(&route.dropped)
+			if dropped != reported[i] {
+				glog.Warningf("Publish queue of topic: %s of subscriber: %s dropped %d messages (%d in total), high-water mark %d/%d",
+					route.topic, route.subscriber, dropped-reported[i], dropped,
+					atomic.LoadUint64(&route.highWater), cap(route.queue))
+				reported[i] = dropped
+			}
+
+			oversized := atomic.LoadUint64(&route.oversized)
+			if oversized != reportedOversized[i] {
+				glog.Warningf("Topic: %s of subscriber: %s skipped %d blobs (%d in total) of %d bytes or more",
+					route.topic, route.subscriber, oversized-reportedOversized[i], oversized, databus.MaxPublishSize)
+				reportedOversized[i] = oversized
+			}
+		}
+	}
+}
+
+// serveMetrics serves the metrics of the opcua server and of the publish queues on metricsEndpoint,
+// at /metrics in the Prometheus text format
+func (opcuaExport *OpcuaExport) serveMetrics() {
+	mux := http.NewServeMux()
+	mux.HandleFunc("/metrics", opcuaExport.writeMetrics)
+	glog.Infof("Serving the metrics on: %s/metrics", opcuaExport.opcuaBus.metricsEndpoint)
+	err := http.ListenAndServe(opcuaExport.opcuaBus.metricsEndpoint, mux)
+	glog.Errorf("Metrics endpoint Error: %v", err)
+}
+
+// mirrorDiagnostics publishes the metrics of the opcua server to its Diagnostics folder every diagnosticsInterval
+func (opcuaExport *OpcuaExport) mirrorDiagnostics() {
+	for range time.Tick(opcuaExport.opcuaBus.diagnosticsInterval) {
+		err := opcuaExport.opcuaBus.opcuaDatab.PublishMetrics()
+		if err != nil {
+			glog.Errorf("Diagnostics publish Error: %v", err)
+		}
+	}
+}
+
+// promSample is a sample of a Prometheus metric, labels being its formatted label pairs
+type promSample struct {
+	labels string
+	value  float64
+}
+
+var promLabelEscaper = strings.NewReplacer(`\`, `\\`, `"`, `\"`, "\n", `\n`)
+
+// promLabels formats the label pairs name1, value1, name2, value2...
+func promLabels(pairs ...string) string {
+	var labels strings.Builder
+	for i := 0; i+1 < len(pairs); i += 2 {
+		if i > 0 {
+			labels.WriteByte(',')
+		}
+		labels.WriteString(pairs[i] + `="` + promLabelEscaper.Replace(pairs[i+1]) + `"`)
+	}
+	return labels.String()
+}
+
+// writePromFamily writes the samples of the metric name of type kind in the Prometheus text format
+func writePromFamily(buf *bytes.Buffer, name string, kind string, help string, samples ...promSample) {
+	fmt.Fprintf(buf, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, kind)
+	for _, sample := range samples {
+		buf.WriteString(name)
+		if sample.labels != "" {
+			buf.WriteString("{" + sample.labels + "}")
+		}
+		buf.WriteString(" " + strconv.FormatFloat(sample.value, 'g', -1, 64) + "\n")
+	}
+}
+
+// writeMetrics is the handler of the Prometheus metrics endpoint
+func (opcuaExport *OpcuaExport) writeMetrics(w http.ResponseWriter, r *http.Request) {
+	metrics, err := opcuaExport.opcuaBus.opcuaDatab.Metrics()
+	if err != nil {
+		http.Error(w, err.Error(), http.StatusInternalServerError)
+		return
+	}
+	var buf bytes.Buffer
+	formatMetrics(&buf, metrics, opcuaExport.PublishQueueStats())
+	w.Header().Set("Content-Type", "text/plain; version=0.0.4")
+	w.Write(buf.Bytes())
+}
+
+// formatMetrics writes the metrics of the opcua server and the counters of the publish queues in the
+// Prometheus text format
+func formatMetrics(buf *bytes.Buffer, metrics *databus.Metrics, queues []PublishQueueStats) {
+	server := &metrics.Server
+	family := func(name string, kind string, help string, value uint64) {
+		writePromFamily(buf, name, kind, help, promSample{value: float64(value)})
+	}
+	family("opcua_export_topics", "gauge", "Topics published to", server.TopicCount)
+	family("opcua_export_secure_channels", "gauge", "Open secure channels", server.CurrentChannelCount)
+	family("opcua_export_secure_channels_opened_total", "counter", "Secure channels opened", server.CumulatedChannelCount)
+	family("opcua_export_secure_channels_rejected_total", "counter", "Secure channels rejected", server.RejectedChannelCount)
+	family("opcua_export_sessions", "gauge", "Open sessions", server.CurrentSessionCount)
+	family("opcua_export_sessions_created_total", "counter", "Sessions created", server.CumulatedSessionCount)
+	family("opcua_export_sessions_rejected_total", "counter", "Sessions rejected", server.RejectedSessionCount)
+	family("opcua_export_sessions_timed_out_total", "counter", "Sessions closed on timeout", server.SessionTimeoutCount)
+	family("opcua_export_sessions_aborted_total", "counter", "Sessions aborted", server.SessionAbortCount)
+	family("opcua_export_registry_lock_waits_total", "counter",
+		"Topic registry lock acquisitions that had to wait for it", server.RegistryLockWaits)
+	writePromFamily(buf, "opcua_export_registry_lock_wait_seconds_total", "counter",
+		"Time spent waiting for the topic registry lock", promSample{value: server.RegistryLockWait.Seconds()})
+
+	topics := metrics.Topics
+	published := make([]promSample, len(topics))
+	bytesPublished := make([]promSample, len(topics))
+	drops := make([]promSample, len(topics))
+	latencies := make([]promSample, 0, 4*len(topics))
+	latencySums := make([]promSample, len(topics))
+	latencyCounts := make([]promSample, len(topics))
+	for i, topic := range topics {
+		labels := promLabels("ns", topic.Ns, "topic", topic.Topic)
+		published[i] = promSample{labels, float64(topic.PublishCount)}
+		bytesPublished[i] = promSample{labels, float64(topic.PublishBytes)}
+		drops[i] = promSample{labels, float64(topic.Drops)}
+		for _, quantile := range []struct {
+			name    string
+			latency time.Duration
+		}{{"0.5", topic.LatencyP50}, {"0.9", topic.LatencyP90}, {"0.99", topic.LatencyP99}, {"0.999", topic.LatencyP999}} {
+			latencies = append(latencies, promSample{labels + `,quantile="` + quantile.name + `"`, quantile.latency.Seconds()})
+		}
+		latencySums[i] = promSample{labels, topic.LatencySum.Seconds()}
+		latencyCounts[i] = promSample{labels, float64(topic.PublishCount)}
+	}
+	writePromFamily(buf, "opcua_export_topic_published_total", "counter", "Values published to the topic", published...)
+	writePromFamily(buf, "opcua_export_topic_published_bytes_total", "counter", "Bytes published to the topic", bytesPublished...)
+	writePromFamily(buf, "opcua_export_topic_dropped_total", "counter",
+		"Values of the topic replaced by the next one before the server took them", drops...)
+	fmt.Fprintf(buf, "# HELP opcua_export_topic_publish_latency_seconds Latency of the publish calls to the topic\n"+
+		"# TYPE opcua_export_topic_publish_latency_seconds summary\n")
+	for _, samples := range []struct {
+		suffix  string
+		samples []promSample
+	}{{"", latencies}, {"_sum", latencySums}, {"_count", latencyCounts}} {
+		for _, sample := range samples.samples {
+			fmt.Fprintf(buf, "opcua_export_topic_publish_latency_seconds%s{%s} %s\n", samples.suffix, sample.labels,
+				strconv.FormatFloat(sample.value, 'g', -1, 64))
 		}
 	}
+
+	lengths := make([]promSample, len(queues))
+	capacities := make([]promSample, len(queues))
+	highWaters := make([]promSample, len(queues))
+	dropped := make([]promSample, len(queues))
+	oversized := make([]promSample, len(queues))
+	for i, queue := range queues {
+		labels := promLabels("subscriber", queue.Subscriber, "topic", queue.Topic)
+		lengths[i] = promSample{labels, float64(queue.Length)}
+		capacities[i] = promSample{labels, float64(queue.Capacity)}
+		highWaters[i] = promSample{labels, float64(queue.HighWater)}
+		dropped[i] = promSample{labels, float64(queue.Dropped)}
+		oversized[i] = promSample{labels, float64(queue.OversizedBlobs)}
+	}
+	writePromFamily(buf, "opcua_export_queue_length", "gauge", "Messages waiting in the publish queue", lengths...)
+	writePromFamily(buf, "opcua_export_queue_capacity", "gauge", "Capacity of the publish queue", capacities...)
+	writePromFamily(buf, "opcua_export_queue_high_water", "gauge", "Highest length of the publish queue", highWaters...)
+	writePromFamily(buf, "opcua_export_queue_dropped_total", "counter",
+		"Messages dropped by the overload policy of the publish queue", dropped...)
+	writePromFamily(buf, "opcua_export_blobs_oversized_total", "counter",
+		"Blobs not published for exceeding the publish size limit", oversized...)
 }
 
-// Publish function publishes data to opcua clients
-func (opcuaExport *OpcuaExport) Publish(data interface{}) {
-	pubTopics := opcuaExport.opcuaBus.pubTopics
-	topicConfigs := make([]map[string]string, len(pubTopics))
-	for i, pubTopic := range pubTopics {
-		topicConfigs[i] = map[string]string{"ns": "StreamManager", "name": pubTopic, "dType": "string"}
+// Publish function publishes data to opcua clients, as "<topic> <data>" on each opcua topic of the
+// route. The data is formatted once and the messages are built in buffers of the route reused by the
+// next calls, so the route is published by one goroutine at a time
+func (opcuaExport *OpcuaExport) Publish(route *opcuaRoute, data interface{}) {
+	route.formatted.Reset()
+	fmt.Fprint(&route.formatted, data)
+	for i, pubTopic := range route.pubTopics {
+		msg := append(route.messages[i][:0], pubTopic...)
+		msg = append(msg, ' ')
+		route.messages[i] = append(msg, route.formatted.Bytes()...)
 	}
-	for _, topicConfig := range topicConfigs {
-		opcuaData := fmt.Sprintf("%s %v", topicConfig["name"], data)
-		opcuaExport.opcuaBus.opcuaDatab.Publish(topicConfig, opcuaData)
-		glog.Infof("Published data: %v on topic: %s\n", opcuaData, topicConfig)
+	err := opcuaExport.opcuaBus.opcuaDatab.PublishTopics(route.topics, route.messages)
+	if err != nil {
+		route.publishError(err, route.topic)
+		return
+	}
+	route.addBytes(route.formatted.Len() * len(route.pubTopics))
+
+	// every message at verbosity 2, a sample of at most one per logSampleInterval at verbosity 1
+	if glog.V(2) {
+		glog.Infof("Published data: %s on topics: %v\n", route.formatted.Bytes(), route.pubTopics)
+	} else if glog.V(1) {
+		if now := time.Now(); now.Sub(route.lastSample) >= logSampleInterval {
+			route.lastSample = now
+			glog.Infof("Published data: %s on topics: %v (sampled)\n", route.formatted.Bytes(), route.pubTopics)
+		}
+	}
+}
+
+// blobTopic returns the handle of the topic "<topic>_blob<blobIndex>" of pubTopics[topicIndex], created
+// the first time a message has that many blobs
+func (bus *opcuaBus) blobTopic(topicIndex int, blobIndex int) (*databus.Topic, error) {
+	bus.blobMutex.RLock()
+	if blobIndex < len(bus.blobTopics[topicIndex]) {
+		topic := bus.blobTopics[topicIndex][blobIndex]
+		bus.blobMutex.RUnlock()
+		return topic, nil
+	}
+	bus.blobMutex.RUnlock()
+
+	bus.blobMutex.Lock()
+	defer bus.blobMutex.Unlock()
+	for len(bus.blobTopics[topicIndex]) <= blobIndex {
+		name := fmt.Sprintf("%s_blob%d", bus.pubTopics[topicIndex], len(bus.blobTopics[topicIndex]))
+		topic, err := bus.opcuaDatab.Topic(map[string]string{"ns": "StreamManager", "name": name, "dType": "bytes"})
+		if err != nil {
+			return nil, err
+		}
+		bus.blobTopics[topicIndex] = append(bus.blobTopics[topicIndex], topic)
+	}
+	return bus.blobTopics[topicIndex][blobIndex], nil
+}
+
+// PublishBlobs function publishes the blob frames of a message to opcua clients as binary
+// ByteString values, blob i going to the topic "<topic>_blob<i>" of each opcua topic of the route.
+// Blobs of databus.MaxPublishSize bytes or more, e.g. video frames, are skipped and counted
+func (opcuaExport *OpcuaExport) PublishBlobs(route *opcuaRoute, blobs [][]byte) {
+	bus := &opcuaExport.opcuaBus
+	for t, pubTopic := range route.pubTopics {
+		for i, blob := range blobs {
+			if len(blob) >= databus.MaxPublishSize {
+				atomic.AddUint64(&route.oversized, 1)
+				continue
+			}
+			topic, err := bus.blobTopic(route.pubIndexes[t], i)
+			if err == nil {
+				err = topic.Publish(blob)
+			}
+			if err != nil {
+				route.publishError(err, fmt.Sprintf("%s_blob%d", pubTopic, i))
+				continue
+			}
+			route.addBytes(len(blob))
+			if glog.V(2) {
+				glog.Infof("Published blob of %d bytes on topic: %s_blob%d\n", len(blob), pubTopic, i)
+			}
+		}
 	}
 }
 
@@ -226,5 +968,11 @@ func main() {
 		os.Exit(1)
 	}
 	opcuaExport.Subscribe()
-	select {}
+
+	// the opcua server is destroyed on shutdown only, the publishes still in progress then fail
+	signals := make(chan os.Signal, 1)
+	signal.Notify(signals, syscall.SIGINT, syscall.SIGTERM)
+	sig := <-signals
+	glog.Infof("Received signal: %v, shutting down", sig)
+	opcuaExport.opcuaBus.opcuaDatab.ContextDestroy()
 }
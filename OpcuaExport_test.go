@@ -0,0 +1,497 @@
+/*
+Copyright (c) 2021 Intel Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+package main
+
+import (
+	eiimsgbus "github.com/open-edge-insights/eii-messagebus-go/eiimsgbus"
+	databus "opcuabusobstraction/go"
+
+	"bytes"
+	"encoding/json"
+	"reflect"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"testing"
+	"time"
+)
+
+// sizes of the data string of the benchmark messages
+var benchPayloadSizes = []int{100, 1024, 10 * 1024, 60 * 1024}
+
+// numbers of opcua topics the benchmark messages are routed to
+var benchFanOuts = []int{1, 4}
+
+// newBenchExport creates an OpcuaExport publishing in dev mode on port, with the route of the topic
+// "results" of the subscriber "bench" to fanOut opcua topics
+func newBenchExport(b *testing.B, port int, fanOut int) (*OpcuaExport, *opcuaRoute) {
+	opcuaExport := &OpcuaExport{devMode: true}
+	bus := &opcuaExport.opcuaBus
+	var err error
+	bus.opcuaDatab, err = databus.NewDataBus()
+	if err != nil {
+		b.Fatal(err)
+	}
+	err = bus.opcuaDatab.ContextCreate(map[string]string{
+		"endpoint":    "opcua://localhost:" + strconv.Itoa(port),
+		"direction":   "PUB",
+		"certFile":    "",
+		"privateFile": "",
+		"trustFile":   "",
+	})
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.Cleanup(func() { bus.opcuaDatab.ContextDestroy() })
+
+	bus.pubTopics = make([]string, fanOut)
+	pubIndexes := make([]int, fanOut)
+	for i := range pubIndexes {
+		bus.pubTopics[i] = "opcua_bench_results" + strconv.Itoa(i)
+		pubIndexes[i] = i
+	}
+	bus.routeTopics = map[string][]int{"bench/results": pubIndexes}
+	bus.routed = make(map[string]bool)
+	bus.queueSize = defaultQueueSize
+	bus.overloadPolicy = defaultOverloadPolicy
+	if err = bus.createTopics(); err != nil {
+		b.Fatal(err)
+	}
+	return opcuaExport, bus.newRoute("bench", "results")
+}
+
+// benchMessage is a msgbus message shaped like the analytics results, with a data string of size bytes
+func benchMessage(size int) *eiimsgbus.MsgEnvelope {
+	return &eiimsgbus.MsgEnvelope{Data: map[string]interface{}{
+		"frame_number":  float64(1234),
+		"encoding_type": "jpeg",
+		"defects": []interface{}{
+			map[string]interface{}{"type": float64(0), "tl": []interface{}{float64(10), float64(20)}},
+		},
+		"data": strings.Repeat("x", size),
+	}}
+}
+
+// checkPublishErrors fails b if publishing on the route failed
+func checkPublishErrors(b *testing.B, opcuaExport *OpcuaExport, route *opcuaRoute) {
+	route.mutex.Lock()
+	defer route.mutex.Unlock()
+	if route.stats.errors != 0 {
+		b.Fatalf("%d publish errors", route.stats.errors)
+	}
+}
+
+// Benchmark of Publish, formatting the data of a message and publishing it on the opcua topics of its route.
+// Run with -benchmem to get allocs/op and B/op.
+func BenchmarkPublish(b *testing.B) {
+	for f, fanOut := range benchFanOuts {
+		opcuaExport, route := newBenchExport(b, 65047+f, fanOut)
+		for _, size := range benchPayloadSizes {
+			msg := benchMessage(size)
+			b.Run("fanout"+strconv.Itoa(fanOut)+"/"+strconv.Itoa(size)+"B", func(b *testing.B) {
+				b.SetBytes(int64(size))
+				b.ReportAllocs()
+				for i := 0; i < b.N; i++ {
+					opcuaExport.Publish(route, msg.Data)
+				}
+				b.StopTimer()
+				checkPublishErrors(b, opcuaExport, route)
+			})
+		}
+	}
+}
+
+// Benchmark of the path of a message from its msgbus subscriber to opcua: receive, the publish queue
+// and the publisher goroutine of the route, fed by an in-process subscriber channel.
+// Run with -benchmem to get allocs/op and B/op.
+func BenchmarkWorker(b *testing.B) {
+	for f, fanOut := range benchFanOuts {
+		opcuaExport, route := newBenchExport(b, 65049+f, fanOut)
+		for _, size := range benchPayloadSizes {
+			msg := benchMessage(size)
+			b.Run("fanout"+strconv.Itoa(fanOut)+"/"+strconv.Itoa(size)+"B", func(b *testing.B) {
+				subscriber := &eiimsgbus.Subscriber{
+					MessageChannel: make(chan *eiimsgbus.MsgEnvelope),
+					ErrorChannel:   make(chan error),
+				}
+				route.queue = make(chan queuedMessage, opcuaExport.opcuaBus.queueSize)
+				var wg sync.WaitGroup
+				wg.Add(1)
+				go receive(opcuaExport, subscriber, route, &wg)
+				published := make(chan struct{})
+				go func() {
+					publisher(opcuaExport, route)
+					close(published)
+				}()
+
+				b.SetBytes(int64(size))
+				b.ReportAllocs()
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					subscriber.MessageChannel <- msg
+				}
+				close(subscriber.MessageChannel)
+				wg.Wait()
+				close(route.queue)
+				<-published
+				b.StopTimer()
+				checkPublishErrors(b, opcuaExport, route)
+			})
+		}
+	}
+}
+
+// newQueueRoute returns an OpcuaExport with the overload policy and a route with a queue of size messages,
+// which no publisher drains
+func newQueueRoute(policy string, size int) (*OpcuaExport, *opcuaRoute) {
+	opcuaExport := &OpcuaExport{}
+	opcuaExport.opcuaBus.overloadPolicy = policy
+	route := &opcuaRoute{subscriber: "queue", topic: "results", queue: make(chan queuedMessage, size)}
+	opcuaExport.opcuaBus.routes = []*opcuaRoute{route}
+	return opcuaExport, route
+}
+
+// queueMessage is a queued message of frame number n
+func queueMessage(n int) queuedMessage {
+	return queuedMessage{msg: &eiimsgbus.MsgEnvelope{Data: map[string]interface{}{"frame_number": float64(n)}}}
+}
+
+// Test case for the overload policies of the publish queues.
+// Checks which messages are kept by a full queue, the dropped messages counter and the high-water mark.
+func TestEnqueue(t *testing.T) {
+	for _, test := range []struct {
+		policy  string
+		kept    []int
+		dropped uint64
+	}{
+		{dropOldest, []int{3, 4, 5}, 3},
+		{dropNewest, []int{0, 1, 2}, 3},
+	} {
+		t.Run(test.policy, func(t *testing.T) {
+			opcuaExport, route := newQueueRoute(test.policy, 3)
+			for n := 0; n < 6; n++ {
+				opcuaExport.enqueue(route, queueMessage(n))
+			}
+			expected := PublishQueueStats{"queue", "results", 3, 3, 3, test.dropped, 0}
+			if stats := opcuaExport.PublishQueueStats(); len(stats) != 1 || stats[0] != expected {
+				t.Errorf("Got the publish queue stats %+v, expected %+v", stats, expected)
+			}
+			for _, n := range test.kept {
+				queued := <-route.queue
+				if frame := queued.msg.Data["frame_number"]; frame != float64(n) {
+					t.Errorf("Got frame %v, expected %d", frame, n)
+				}
+			}
+		})
+	}
+
+	t.Run(block, func(t *testing.T) {
+		opcuaExport, route := newQueueRoute(block, 2)
+		opcuaExport.enqueue(route, queueMessage(0))
+		opcuaExport.enqueue(route, queueMessage(1))
+		enqueued := make(chan struct{})
+		go func() {
+			opcuaExport.enqueue(route, queueMessage(2))
+			close(enqueued)
+		}()
+		select {
+		case <-enqueued:
+			t.Fatal("enqueue returned on a full queue")
+		case <-time.After(100 * time.Millisecond):
+		}
+		<-route.queue
+		select {
+		case <-enqueued:
+		case <-time.After(5 * time.Second):
+			t.Fatal("enqueue is still blocked once the queue has room")
+		}
+		expected := PublishQueueStats{"queue", "results", 2, 2, 2, 0, 0}
+		if stats := opcuaExport.PublishQueueStats(); len(stats) != 1 || stats[0] != expected {
+			t.Errorf("Got the publish queue stats %+v, expected %+v", stats, expected)
+		}
+	})
+}
+
+// Test case for the blobs exceeding the publish size limit.
+// Checks they are counted as oversized without being published or counted as publish errors.
+func TestPublishBlobsOversized(t *testing.T) {
+	opcuaExport, route := newQueueRoute(dropOldest, 1)
+	route.pubIndexes = []int{0}
+	route.pubTopics = []string{"opcua_cam1"}
+	frame := make([]byte, databus.MaxPublishSize)
+	opcuaExport.PublishBlobs(route, [][]byte{frame, frame})
+
+	expected := PublishQueueStats{"queue", "results", 0, 1, 0, 0, 2}
+	if stats := opcuaExport.PublishQueueStats(); len(stats) != 1 || stats[0] != expected {
+		t.Errorf("Got the publish queue stats %+v, expected %+v", stats, expected)
+	}
+	if route.stats != (publishStats{}) {
+		t.Errorf("Got the publish stats %+v for oversized blobs", route.stats)
+	}
+}
+
+// Test case for the routing config.
+// Checks the opcua topics parseRoutes registers, and the ones newRoute resolves for the subscribed topics:
+// routed and unrouted topics, duplicate opcua topics, routes matching no subscribed topic, the routes
+// publishing their blobs and the legacy OpcuaDatabusTopics publishing every message on all its topics.
+func TestRoutes(t *testing.T) {
+	type subscribed struct {
+		subscriber string
+		topic      string
+		pubTopics  []string // nil when the topic isn't routed
+	}
+	for _, test := range []struct {
+		name       string
+		appConfig  string
+		err        bool
+		pubTopics  []string
+		subscribed []subscribed
+		unmatched  []string
+		blobs      []string // "<subscriber>/<topic>" of the routes publishing their blobs
+	}{
+		{
+			name: "routes",
+			appConfig: `{"OpcuaRoutes": [
+				{"Subscriber": "va", "Topic": "cam1", "OpcuaTopics": ["opcua_cam1", "opcua_all"], "PublishBlobs": true},
+				{"Subscriber": "va", "Topic": "cam2", "OpcuaTopics": ["opcua_cam2"], "PublishBlobs": false},
+				{"Subscriber": "ts", "Topic": "cam1", "OpcuaTopics": ["opcua_ts"]}]}`,
+			pubTopics: []string{"opcua_cam1", "opcua_all", "opcua_cam2", "opcua_ts"},
+			subscribed: []subscribed{
+				{"va", "cam1", []string{"opcua_cam1", "opcua_all"}},
+				{"va", "cam2", []string{"opcua_cam2"}},
+				{"ts", "cam1", []string{"opcua_ts"}},
+				{"ts", "cam2", nil},
+			},
+			blobs: []string{"va/cam1"},
+		},
+		{
+			name: "duplicate topics",
+			appConfig: `{"OpcuaRoutes": [
+				{"Subscriber": "va", "Topic": "cam1", "OpcuaTopics": ["opcua_all", "opcua_all"]},
+				{"Subscriber": "va", "Topic": "cam2", "OpcuaTopics": ["opcua_all"]},
+				{"Subscriber": "va", "Topic": "cam1", "OpcuaTopics": ["opcua_cam1", "opcua_all"]}]}`,
+			pubTopics: []string{"opcua_all", "opcua_cam1"},
+			subscribed: []subscribed{
+				{"va", "cam1", []string{"opcua_all", "opcua_cam1"}},
+				{"va", "cam2", []string{"opcua_all"}},
+			},
+		},
+		{
+			name: "unmatched routes",
+			appConfig: `{"OpcuaRoutes": [
+				{"Subscriber": "va", "Topic": "cam1", "OpcuaTopics": ["opcua_cam1"]},
+				{"Subscriber": "va", "Topic": "cam3", "OpcuaTopics": ["opcua_cam3"]},
+				{"Subscriber": "gone", "Topic": "cam1", "OpcuaTopics": ["opcua_gone"]}]}`,
+			pubTopics:  []string{"opcua_cam1", "opcua_cam3", "opcua_gone"},
+			subscribed: []subscribed{{"va", "cam1", []string{"opcua_cam1"}}},
+			unmatched:  []string{"gone/cam1", "va/cam3"},
+		},
+		{
+			name:      "legacy broadcast",
+			appConfig: `{"OpcuaDatabusTopics": ["opcua_cam1", "opcua_cam2", "opcua_cam1"]}`,
+			pubTopics: []string{"opcua_cam1", "opcua_cam2"},
+			subscribed: []subscribed{
+				{"", "cam1", []string{"opcua_cam1", "opcua_cam2"}},
+				{"", "cam2", []string{"opcua_cam1", "opcua_cam2"}},
+			},
+		},
+		{
+			name:       "legacy broadcast without topics",
+			appConfig:  `{"OpcuaDatabusTopics": []}`,
+			subscribed: []subscribed{{"", "cam1", nil}},
+		},
+		{name: "no topics", appConfig: `{}`, err: true},
+		{name: "routes not a list", appConfig: `{"OpcuaRoutes": {}}`, err: true},
+		{name: "route without topics", appConfig: `{"OpcuaRoutes": [{"Subscriber": "va", "Topic": "cam1"}]}`, err: true},
+		{
+			name:      "topic not a string",
+			appConfig: `{"OpcuaRoutes": [{"Subscriber": "va", "Topic": "cam1", "OpcuaTopics": [1]}]}`,
+			err:       true,
+		},
+		{
+			name:      "PublishBlobs not a boolean",
+			appConfig: `{"OpcuaRoutes": [{"Subscriber": "va", "Topic": "cam1", "OpcuaTopics": ["opcua_cam1"], "PublishBlobs": "yes"}]}`,
+			err:       true,
+		},
+		{name: "legacy topic not a string", appConfig: `{"OpcuaDatabusTopics": [true]}`, err: true},
+	} {
+		t.Run(test.name, func(t *testing.T) {
+			var appConfig map[string]interface{}
+			if err := json.Unmarshal([]byte(test.appConfig), &appConfig); err != nil {
+				t.Fatal(err)
+			}
+			bus := &opcuaBus{}
+			err := bus.parseRoutes(appConfig)
+			if test.err {
+				if err == nil {
+					t.Fatal("parseRoutes succeeded")
+				}
+				return
+			}
+			if err != nil {
+				t.Fatal(err)
+			}
+			if !reflect.DeepEqual(bus.pubTopics, test.pubTopics) {
+				t.Fatalf("Got the opcua topics %v, expected %v", bus.pubTopics, test.pubTopics)
+			}
+
+			// the topic handles are not created, newRoute copies them only
+			bus.topics = make([]*databus.Topic, len(bus.pubTopics))
+			var blobs []string
+			for _, sub := range test.subscribed {
+				route := bus.newRoute(sub.subscriber, sub.topic)
+				if sub.pubTopics == nil {
+					if route != nil {
+						t.Errorf("Topic %s of %s is routed to %v", sub.topic, sub.subscriber, route.pubTopics)
+					}
+					continue
+				}
+				if route == nil {
+					t.Errorf("Topic %s of %s isn't routed", sub.topic, sub.subscriber)
+					continue
+				}
+				if !reflect.DeepEqual(route.pubTopics, sub.pubTopics) {
+					t.Errorf("Topic %s of %s is routed to %v, expected %v", sub.topic, sub.subscriber,
+						route.pubTopics, sub.pubTopics)
+				}
+				for i, pubIndex := range route.pubIndexes {
+					if bus.pubTopics[pubIndex] != route.pubTopics[i] {
+						t.Errorf("Index %d of %s is not the one of %s", pubIndex, bus.pubTopics[pubIndex], route.pubTopics[i])
+					}
+				}
+				if route.publishBlobs {
+					blobs = append(blobs, sub.subscriber+"/"+sub.topic)
+				}
+			}
+			if !reflect.DeepEqual(blobs, test.blobs) {
+				t.Errorf("Got the routes publishing their blobs %v, expected %v", blobs, test.blobs)
+			}
+
+			var unmatched []string
+			for key := range bus.routeTopics {
+				if !bus.routed[key] {
+					unmatched = append(unmatched, key)
+				}
+			}
+			sort.Strings(unmatched)
+			if !reflect.DeepEqual(unmatched, test.unmatched) {
+				t.Errorf("Got the unmatched routes %v, expected %v", unmatched, test.unmatched)
+			}
+		})
+	}
+}
+
+// Test case for the metrics config.
+// Checks that in prod mode the metrics endpoint is refused unless it listens on a loopback address only.
+func TestParseMetrics(t *testing.T) {
+	for _, test := range []struct {
+		endpoint string
+		devMode  bool
+		err      bool
+	}{
+		{"127.0.0.1:65104", false, false},
+		{"localhost:65104", false, false},
+		{"[::1]:65104", false, false},
+		{"", false, false},
+		{"0.0.0.0:65104", false, true},
+		{":65104", false, true},
+		{"ia_opcua_export:65104", false, true},
+		{"65104", false, true},
+		{"0.0.0.0:65104", true, false},
+		{":65104", true, false},
+	} {
+		bus := &opcuaBus{}
+		appConfig := map[string]interface{}{"Metrics": map[string]interface{}{"Endpoint": test.endpoint}}
+		err := bus.parseMetrics(appConfig, test.devMode)
+		if (err != nil) != test.err {
+			t.Errorf("parseMetrics of the endpoint %q in dev mode %v returned %v", test.endpoint, test.devMode, err)
+		}
+	}
+
+	bus := &opcuaBus{}
+	if err := bus.parseMetrics(map[string]interface{}{}, false); err != nil || bus.metricsEndpoint != "" {
+		t.Errorf("The metrics endpoint is enabled by default: %v, %q", err, bus.metricsEndpoint)
+	}
+}
+
+// Test case for the Prometheus text of the metrics endpoint.
+// Checks the samples formatted from fixed metrics, the escaping of the label values and the _sum and
+// _count samples of the latency summary.
+func TestFormatMetrics(t *testing.T) {
+	metrics := &databus.Metrics{
+		Server: databus.ServerMetrics{
+			TopicCount:          2,
+			CurrentSessionCount: 3,
+			RegistryLockWait:    1500 * time.Millisecond,
+		},
+		Topics: []databus.TopicMetrics{
+			{
+				Ns: "StreamManager", Topic: "cam1", PublishCount: 10, PublishBytes: 2048, Drops: 1,
+				LatencySum: 2 * time.Second, LatencyP50: 100 * time.Millisecond, LatencyP90: 200 * time.Millisecond,
+				LatencyP99: 250 * time.Millisecond, LatencyP999: 500 * time.Millisecond,
+			},
+			{Ns: `a"b\c`, Topic: "line\nbreak", PublishCount: 4, LatencySum: 250 * time.Millisecond},
+		},
+	}
+	queues := []PublishQueueStats{{Subscriber: `va"1`, Topic: "results", Length: 5, Capacity: 64, HighWater: 9, Dropped: 7,
+		OversizedBlobs: 2}}
+	var buf bytes.Buffer
+	formatMetrics(&buf, metrics, queues)
+	text := buf.String()
+
+	for _, line := range []string{
+		"# TYPE opcua_export_topics gauge\nopcua_export_topics 2\n",
+		"opcua_export_sessions 3\n",
+		"opcua_export_registry_lock_wait_seconds_total 1.5\n",
+		`opcua_export_topic_published_total{ns="StreamManager",topic="cam1"} 10` + "\n",
+		`opcua_export_topic_published_bytes_total{ns="StreamManager",topic="cam1"} 2048` + "\n",
+		`opcua_export_topic_dropped_total{ns="StreamManager",topic="cam1"} 1` + "\n",
+		`opcua_export_topic_published_total{ns="a\"b\\c",topic="line\nbreak"} 4` + "\n",
+		"# TYPE opcua_export_topic_publish_latency_seconds summary\n",
+		`opcua_export_topic_publish_latency_seconds{ns="StreamManager",topic="cam1",quantile="0.5"} 0.1` + "\n",
+		`opcua_export_topic_publish_latency_seconds{ns="StreamManager",topic="cam1",quantile="0.999"} 0.5` + "\n",
+		`opcua_export_topic_publish_latency_seconds_sum{ns="StreamManager",topic="cam1"} 2` + "\n",
+		`opcua_export_topic_publish_latency_seconds_count{ns="StreamManager",topic="cam1"} 10` + "\n",
+		`opcua_export_topic_publish_latency_seconds_sum{ns="a\"b\\c",topic="line\nbreak"} 0.25` + "\n",
+		`opcua_export_topic_publish_latency_seconds_count{ns="a\"b\\c",topic="line\nbreak"} 4` + "\n",
+		`opcua_export_queue_length{subscriber="va\"1",topic="results"} 5` + "\n",
+		`opcua_export_queue_capacity{subscriber="va\"1",topic="results"} 64` + "\n",
+		`opcua_export_queue_high_water{subscriber="va\"1",topic="results"} 9` + "\n",
+		`opcua_export_queue_dropped_total{subscriber="va\"1",topic="results"} 7` + "\n",
+		`opcua_export_blobs_oversized_total{subscriber="va\"1",topic="results"} 2` + "\n",
+	} {
+		if !strings.Contains(text, line) {
+			t.Errorf("Missing %q in the metrics:\n%s", line, text)
+		}
+	}
+	// label values never break a sample over several lines
+	for _, line := range strings.Split(strings.TrimSuffix(text, "\n"), "\n") {
+		if !strings.HasPrefix(line, "# ") && !strings.HasPrefix(line, "opcua_export_") {
+			t.Errorf("Malformed line %q in the metrics", line)
+		}
+	}
+	if count := strings.Count(text, "# TYPE opcua_export_topic_publish_latency_seconds "); count != 1 {
+		t.Errorf("The latency summary is declared %d times", count)
+	}
+}